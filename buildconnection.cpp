@@ -0,0 +1,176 @@
+#include "buildconnection.h"
+#include <QtDebug>
+
+// Anything bigger than this can't be a legitimate message (blobs are sent in chunks), so the peer is either broken or malicious.
+static const quint32 MaxMessageSize = 64 * 1024 * 1024;
+
+// How much of a file goes into a single chunk message.
+static const qint64 BlobChunkSize = 1024 * 1024;
+
+// Don't queue up more chunks than this in the socket, so big transfers are read from disk as they're sent.
+static const qint64 MaxQueuedBytes = 4 * 1024 * 1024;
+
+BuildConnection::BuildConnection(QTcpSocket *Socket, QObject *parent) :
+    QObject(parent),
+    Socket(Socket)
+{
+    Socket->setParent(this);
+
+    // Both ends need to agree on the serialization format, regardless of the Qt version they were built with.
+    Stream.setDevice(Socket);
+    Stream.setVersion(QDataStream::Qt_5_7);
+
+    connect(Socket, &QTcpSocket::readyRead, this, &BuildConnection::on_Socket_readyRead);
+    connect(Socket, &QTcpSocket::bytesWritten, this, &BuildConnection::on_Socket_bytesWritten);
+    connect(Socket, &QTcpSocket::disconnected, this, &BuildConnection::Disconnected);
+}
+
+BuildConnection::~BuildConnection()
+{
+    delete CurrentBlob;
+}
+
+void BuildConnection::Send(QVariantMap Message)
+{
+    QByteArray Payload;
+    QDataStream PayloadStream(&Payload, QIODevice::WriteOnly);
+    PayloadStream.setVersion(QDataStream::Qt_5_7);
+    PayloadStream << Message;
+
+    if (quint32(Payload.size()) > MaxMessageSize)
+    {
+        // The other side would drop the connection over it anyway.
+        qDebug() << "Not Sending " << Message["type"].toString() << " Message As It Is Too Big (" << Payload.size() << " Bytes)!";
+        return;
+    }
+
+    Stream << quint32(Payload.size());
+    Socket->write(Payload);
+}
+
+void BuildConnection::SendBlobs(QString JobId, QStringList Hashes, QMap<QString, QString> PathsByHash)
+{
+    BlobTransfer Transfer;
+    Transfer.JobId = JobId;
+    Transfer.Hashes = Hashes;
+    Transfer.PathsByHash = PathsByHash;
+    Transfers.append(Transfer);
+
+    SendQueuedBlobs();
+}
+
+QTcpSocket *BuildConnection::GetSocket()
+{
+    return Socket;
+}
+
+void BuildConnection::on_Socket_readyRead()
+{
+    forever
+    {
+        // Every message starts with its length, so we know when all of it has arrived without having to try to parse it.
+        if (PendingLength == 0)
+        {
+            if (Socket->bytesAvailable() < qint64(sizeof(quint32)))
+            {
+                return;
+            }
+
+            Stream >> PendingLength;
+
+            if (PendingLength == 0 || PendingLength > MaxMessageSize)
+            {
+                qDebug() << "Received Invalid Message Length " << PendingLength << " From " << Socket->peerAddress().toString() << "....Dropping The Connection.";
+                Socket->abort();
+                return;
+            }
+        }
+
+        if (Socket->bytesAvailable() < qint64(PendingLength))
+        {
+            // Not everything has arrived yet - try again when there's more data.
+            return;
+        }
+
+        QByteArray Payload = Socket->read(PendingLength);
+        PendingLength = 0;
+
+        QDataStream PayloadStream(Payload);
+        PayloadStream.setVersion(QDataStream::Qt_5_7);
+
+        QVariantMap Message;
+        PayloadStream >> Message;
+
+        if (PayloadStream.status() != QDataStream::Ok)
+        {
+            qDebug() << "Received Corrupted Message From " << Socket->peerAddress().toString() << "....Dropping The Connection.";
+            Socket->abort();
+            return;
+        }
+
+#ifdef QT_DEBUG
+        qDebug() << "Received Build Message: " << Message["type"].toString() << " From " << Socket->peerAddress().toString() << ":" << Socket->peerPort();
+#endif
+
+        emit MessageReceived(Message);
+    }
+}
+
+void BuildConnection::on_Socket_bytesWritten()
+{
+    SendQueuedBlobs();
+}
+
+void BuildConnection::SendQueuedBlobs()
+{
+    while (!Transfers.isEmpty() && Socket->bytesToWrite() < MaxQueuedBytes)
+    {
+        BlobTransfer &Transfer = Transfers.first();
+
+        if (!CurrentBlob)
+        {
+            if (Transfer.Hashes.isEmpty())
+            {
+                // Everything has been sent, so let the other side (and our owner) know.
+                QString JobId = Transfer.JobId;
+                Transfers.removeFirst();
+
+                QVariantMap Done;
+                Done["type"] = "blobs";
+                Done["job"] = JobId;
+                Send(Done);
+
+                emit BlobsSent(JobId);
+                continue;
+            }
+
+            CurrentBlob = new QFile(Transfer.PathsByHash.value(Transfer.Hashes.first()));
+            if (!CurrentBlob->open(QFile::ReadOnly))
+            {
+#ifdef QT_DEBUG
+                qDebug() << "Unable To Read Blob " << Transfer.Hashes.first() << " @ " << CurrentBlob->fileName();
+#endif
+                // The other side will notice it's missing when it checks the job out.
+                delete CurrentBlob;
+                CurrentBlob = nullptr;
+                Transfer.Hashes.removeFirst();
+                continue;
+            }
+        }
+
+        QVariantMap Chunk;
+        Chunk["type"] = "chunk";
+        Chunk["job"] = Transfer.JobId;
+        Chunk["hash"] = Transfer.Hashes.first();
+        Chunk["data"] = qCompress(CurrentBlob->read(BlobChunkSize));
+        Chunk["final"] = CurrentBlob->atEnd();
+        Send(Chunk);
+
+        if (Chunk["final"].toBool())
+        {
+            delete CurrentBlob;
+            CurrentBlob = nullptr;
+            Transfer.Hashes.removeFirst();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef BUILDCONNECTION_H
+#define BUILDCONNECTION_H
+
+#include <QObject>
+#include <QTcpSocket>
+#include <QDataStream>
+#include <QVariantMap>
+#include <QFile>
+
+// The default port the coordinator listens on for workers.
+#define BUILD_COORDINATOR_DEFAULT_PORT 47100
+
+// Wraps a socket between the coordinator & a worker, and turns the byte stream into messages.
+/// NOTE: Every message is a QVariantMap with a "type" key (hello, job, need, chunk, blobs or result), serialized using QDataStream & prefixed with its length.
+class BuildConnection : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Takes ownership of the socket.
+    BuildConnection(QTcpSocket *Socket, QObject *parent = 0);
+    ~BuildConnection();
+
+    void Send(QVariantMap Message);
+
+    // Stream the files for the given hashes to the other side as "chunk" messages, followed by a "blobs" message once they've all been sent.
+    /// NOTE: Files are read a chunk at a time as the socket drains, so large outputs never have to be held in memory.
+    void SendBlobs(QString JobId, QStringList Hashes, QMap<QString, QString> PathsByHash);
+
+    QTcpSocket *GetSocket();
+
+signals:
+    void MessageReceived(QVariantMap Message);
+
+    void Disconnected();
+
+    // All of the job's blobs have been handed to the socket, so the files they were read from are no longer needed.
+    void BlobsSent(QString JobId);
+
+private slots:
+    void on_Socket_readyRead();
+
+    void on_Socket_bytesWritten();
+
+private:
+    struct BlobTransfer
+    {
+        QString JobId;
+        QStringList Hashes;
+        QMap<QString, QString> PathsByHash;
+    };
+
+    // Queue up as many chunks as the socket has room for.
+    void SendQueuedBlobs();
+
+    QTcpSocket *Socket;
+
+    QDataStream Stream;
+
+    // The length of the message we're waiting on (0 if we haven't read its length yet).
+    quint32 PendingLength = 0;
+
+    QList<BlobTransfer> Transfers;
+
+    // The file (of the first transfer) that's currently being sent.
+    QFile *CurrentBlob = nullptr;
+};
+
+#endif // BUILDCONNECTION_H
@@ -0,0 +1,304 @@
+#include "buildcoordinator.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+
+// Compare the tokens without bailing out at the first difference, so the time it takes doesn't give away how much of a guess was right.
+static bool TokensMatch(QString Received, QString Expected)
+{
+    QByteArray ReceivedBytes = Received.toUtf8();
+    QByteArray ExpectedBytes = Expected.toUtf8();
+
+    int Difference = ReceivedBytes.size() ^ ExpectedBytes.size();
+    for (int i = 0; i < ExpectedBytes.size(); i++)
+    {
+        Difference |= ExpectedBytes[i] ^ (i < ReceivedBytes.size() ? ReceivedBytes[i] : 0);
+    }
+
+    return Difference == 0;
+}
+
+BuildCoordinator::BuildCoordinator(QObject *parent) :
+    QObject(parent),
+    Store(QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/CoordinatorStore")
+{
+    // Outputs only pass through the store on their way to their target, so anything in it is left over from a previous session.
+    Store.Trim(0);
+
+    connect(&Server, &QTcpServer::newConnection, this, &BuildCoordinator::on_Server_newConnection);
+}
+
+BuildCoordinator::~BuildCoordinator()
+{
+    for (RemoteWorker *Worker : Workers)
+    {
+        // We're going away, so we don't care about the workers disconnecting anymore.
+        Worker->Connection->disconnect(this);
+        delete Worker;
+    }
+}
+
+bool BuildCoordinator::Listen(quint16 Port, QString Token)
+{
+    if (Token.isEmpty())
+    {
+        qDebug() << "Not Listening For Build Workers As No CoordinatorToken Has Been Set!";
+        return false;
+    }
+
+    this->Token = Token;
+
+    if (!Server.listen(QHostAddress::Any, Port))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Listen For Build Workers On Port " << Port << ": " << Server.errorString();
+#endif
+        return false;
+    }
+
+#ifdef QT_DEBUG
+    qDebug() << "Listening For Build Workers On Port " << Server.serverPort();
+#endif
+
+    return true;
+}
+
+bool BuildCoordinator::CanDispatch(BuildJob Job)
+{
+    return FindWorker(Job.EngineName, UnrealInstall(Job.EngineName, Job.EnginePath).GetVersion()) != nullptr;
+}
+
+bool BuildCoordinator::Dispatch(BuildJob Job)
+{
+    QString EngineVersion = UnrealInstall(Job.EngineName, Job.EnginePath).GetVersion();
+
+    RemoteWorker *Worker = FindWorker(Job.EngineName, EngineVersion);
+    if (!Worker)
+    {
+        return false;
+    }
+
+    QFileInfo PluginFile(Job.PluginPath);
+
+    RemoteJob Remote;
+    Remote.Job = Job;
+    Remote.Worker = Worker;
+
+    // Only the sources are needed to build the plugin - leave out any previous build products.
+    QVariantList Manifest = ContentStore::CreateManifest(PluginFile.absolutePath(), QStringList() << "Binaries" << "Intermediate", Remote.SourcePaths);
+
+    Jobs.insert(Job.Id, Remote);
+    Worker->JobIds.append(Job.Id);
+
+    QVariantMap Message;
+    Message["type"] = "job";
+    Message["job"] = Job.Id;
+    Message["engine"] = Job.EngineName;
+    Message["engineVersion"] = EngineVersion;
+    Message["pluginDir"] = PluginFile.absoluteDir().dirName();
+    Message["pluginFile"] = PluginFile.fileName();
+    Message["manifest"] = Manifest;
+    Worker->Connection->Send(Message);
+
+#ifdef QT_DEBUG
+    qDebug() << "Dispatched Job " << Job.Id << " (" << Job.PluginPath << ") To Worker @ " << Worker->Connection->GetSocket()->peerAddress().toString();
+#endif
+
+    return true;
+}
+
+void BuildCoordinator::on_Server_newConnection()
+{
+    while (Server.hasPendingConnections())
+    {
+        RemoteWorker *Worker = new RemoteWorker();
+        Worker->Connection = new BuildConnection(Server.nextPendingConnection(), this);
+
+        // The worker won't get any jobs until it has told us which engines it has (in its hello message).
+        Workers.append(Worker);
+
+        connect(Worker->Connection, &BuildConnection::MessageReceived, this, [this, Worker](QVariantMap Message) { on_Worker_message(Worker, Message); });
+        connect(Worker->Connection, &BuildConnection::Disconnected, this, [this, Worker]() { on_Worker_disconnected(Worker); });
+    }
+}
+
+void BuildCoordinator::on_Worker_message(RemoteWorker *Worker, QVariantMap Message)
+{
+    QString Type = Message["type"].toString();
+
+    // Anyone can connect to the port, so don't listen to anything until the worker has proven it knows the token.
+    if (!Worker->bAuthenticated && (Type != "hello" || !TokensMatch(Message["token"].toString(), Token)))
+    {
+        qDebug() << "Rejecting Build Worker @ " << Worker->Connection->GetSocket()->peerAddress().toString() << " As It Didn't Send The Right Token!";
+
+        // Aborting disconnects (and deletes) the worker right away.
+        Worker->Connection->GetSocket()->abort();
+        return;
+    }
+
+    if (Type == "hello")
+    {
+        Worker->bAuthenticated = true;
+
+        Worker->EngineNames.clear();
+        Worker->EngineVersions.clear();
+        for (QVariant EngineVal : Message["engines"].toList())
+        {
+            Worker->EngineNames.append(EngineVal.toMap()["name"].toString());
+            Worker->EngineVersions.append(EngineVal.toMap()["version"].toString());
+        }
+        Worker->Capacity = qMax(1, Message["capacity"].toInt());
+
+#ifdef QT_DEBUG
+        qDebug() << "Worker Registered With Engines " << Worker->EngineNames << " (Versions " << Worker->EngineVersions << ") & Capacity " << Worker->Capacity;
+#endif
+
+        emit WorkerAvailable();
+        return;
+    }
+
+    QString Id = Message["job"].toString();
+    if (!Jobs.contains(Id) || Jobs[Id].Worker != Worker)
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Received " << Type << " Message For Unknown Job " << Id;
+#endif
+        return;
+    }
+
+    RemoteJob &Remote = Jobs[Id];
+
+    if (Type == "need")
+    {
+        // The worker wants the sources it doesn't have from previous builds.
+        Worker->Connection->SendBlobs(Id, Message["hashes"].toStringList(), Remote.SourcePaths);
+    }
+    else if (Type == "result")
+    {
+        Remote.OutputLog = Message["log"].toString();
+
+        if (!Message["success"].toBool())
+        {
+            FinishJob(Id, false, Remote.OutputLog);
+            return;
+        }
+
+        // Ask for whichever outputs we don't already have (even if that's none, so the worker knows it can clean up).
+        Remote.OutputManifest = Message["manifest"].toList();
+
+        QVariantMap Need;
+        Need["type"] = "need";
+        Need["job"] = Id;
+        Need["hashes"] = Store.Missing(Remote.OutputManifest);
+        Worker->Connection->Send(Need);
+    }
+    else if (Type == "chunk")
+    {
+        if (!Store.ReceiveChunk(Id, Message["hash"].toString(), Message["data"].toByteArray(), Message["final"].toBool()))
+        {
+            Remote.bOutputsValid = false;
+        }
+    }
+    else if (Type == "blobs")
+    {
+        // We've got all of the outputs now, so put them where a local build would have.
+        QDir().mkpath(Remote.Job.Target);
+
+        if (!Remote.bOutputsValid || !Store.Checkout(Remote.OutputManifest, Remote.Job.Target))
+        {
+            FinishJob(Id, false, Remote.OutputLog + "\nUnable to copy the packaged plugin back from the worker.");
+            return;
+        }
+
+        FinishJob(Id, true, Remote.OutputLog);
+    }
+}
+
+void BuildCoordinator::on_Worker_disconnected(RemoteWorker *Worker)
+{
+#ifdef QT_DEBUG
+    qDebug() << "Worker Disconnected With " << Worker->JobIds.size() << " Job(s) Still In Progress.";
+#endif
+
+    Workers.removeOne(Worker);
+
+    // Hand the jobs it was working on back so they can be built elsewhere.
+    for (QString Id : Worker->JobIds)
+    {
+        RemoteJob Remote = Jobs.take(Id);
+        Store.Discard(Id);
+        ReleaseOutputs(Remote);
+        emit JobLost(Remote.Job);
+    }
+
+    Worker->Connection->deleteLater();
+    delete Worker;
+}
+
+BuildCoordinator::RemoteWorker *BuildCoordinator::FindWorker(QString EngineName, QString EngineVersion)
+{
+    RemoteWorker *BestWorker = nullptr;
+    double BestLoad = 1.0;
+
+    for (RemoteWorker *Worker : Workers)
+    {
+        bool bHasEngine = false;
+        for (int i = 0; i < Worker->EngineNames.size() && !bHasEngine; i++)
+        {
+            bHasEngine = UnrealInstall::IsSameEngine(Worker->EngineNames[i], Worker->EngineVersions[i], EngineName, EngineVersion);
+        }
+
+        if (!bHasEngine)
+        {
+            continue;
+        }
+
+        // Spread the jobs out over the workers relative to how many builds each of them can handle.
+        double Load = double(Worker->JobIds.size()) / Worker->Capacity;
+        if (Load < BestLoad)
+        {
+            BestWorker = Worker;
+            BestLoad = Load;
+        }
+    }
+
+    return BestWorker;
+}
+
+void BuildCoordinator::FinishJob(QString Id, bool bSucceeded, QString OutputLog)
+{
+    RemoteJob Remote = Jobs.take(Id);
+    Remote.Worker->JobIds.removeOne(Id);
+    Store.Discard(Id);
+    ReleaseOutputs(Remote);
+
+    emit JobFinished(Remote.Job, bSucceeded, OutputLog);
+    emit WorkerAvailable();
+}
+
+void BuildCoordinator::ReleaseOutputs(const RemoteJob &Remote)
+{
+    // Other jobs may have skipped asking for these because they were already in the store.
+    QSet<QString> StillNeeded;
+    for (const RemoteJob &Other : Jobs)
+    {
+        for (QVariant EntryVal : Other.OutputManifest)
+        {
+            StillNeeded.insert(EntryVal.toMap()["hash"].toString());
+        }
+    }
+
+    QStringList Unneeded;
+    for (QVariant EntryVal : Remote.OutputManifest)
+    {
+        QString Hash = EntryVal.toMap()["hash"].toString();
+        if (!StillNeeded.contains(Hash))
+        {
+            Unneeded.append(Hash);
+        }
+    }
+
+    Store.Remove(Unneeded);
+}
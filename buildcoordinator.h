@@ -0,0 +1,99 @@
+#ifndef BUILDCOORDINATOR_H
+#define BUILDCOORDINATOR_H
+
+#include <QObject>
+#include <QMap>
+#include <QTcpServer>
+
+#include "buildjournal.h"
+#include "unrealinstall.h"
+#include "buildconnection.h"
+#include "contentstore.h"
+
+// Accepts connections from build workers (on this or other machines) and hands them plugin builds for the engines they have installed.
+class BuildCoordinator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BuildCoordinator(QObject *parent = 0);
+    ~BuildCoordinator();
+
+    // Listen for workers on all interfaces. Workers have to send the token in their hello message before they're trusted with anything.
+    /// NOTE: Refuses to listen without a token, as anyone who can reach the port could otherwise read the plugin sources & write to the output folder.
+    bool Listen(quint16 Port, QString Token);
+
+    // Whether any connected worker has the job's engine installed & a free build slot.
+    bool CanDispatch(BuildJob Job);
+
+    // Send the job to the least loaded worker that has its engine. The job's target has to be resolved already.
+    bool Dispatch(BuildJob Job);
+
+signals:
+    // A worker has connected (or finished a job), so there may be room for more jobs.
+    void WorkerAvailable();
+
+    // A job has been built (and on success, its outputs have been copied to the job's target).
+    void JobFinished(BuildJob Job, bool bSucceeded, QString OutputLog);
+
+    // The worker building a job went away, so it'll have to be built again.
+    void JobLost(BuildJob Job);
+
+private:
+    struct RemoteWorker
+    {
+        BuildConnection *Connection = nullptr;
+        // The names & versions (empty if unknown) of the worker's engine installs.
+        QStringList EngineNames;
+        QStringList EngineVersions;
+        int Capacity = 0;
+
+        // Whether the worker has sent the right token yet.
+        bool bAuthenticated = false;
+
+        // The jobs the worker is currently working on.
+        QStringList JobIds;
+    };
+
+    struct RemoteJob
+    {
+        BuildJob Job;
+        RemoteWorker *Worker = nullptr;
+
+        // Where each of the plugin's source files lives (by hash) so they can be sent when the worker asks for them.
+        QMap<QString, QString> SourcePaths;
+
+        QVariantList OutputManifest;
+        QString OutputLog;
+
+        // Cleared if any of the output chunks the worker sent couldn't be stored.
+        bool bOutputsValid = true;
+    };
+
+    void on_Server_newConnection();
+
+    void on_Worker_message(RemoteWorker *Worker, QVariantMap Message);
+
+    void on_Worker_disconnected(RemoteWorker *Worker);
+
+    // Get the worker with the lowest load that has the engine (matched by version when known, otherwise by name) & a free slot (if any).
+    RemoteWorker *FindWorker(QString EngineName, QString EngineVersion);
+
+    void FinishJob(QString Id, bool bSucceeded, QString OutputLog);
+
+    // Remove a finished job's outputs from the store (they're in its target now) unless another job still needs them.
+    void ReleaseOutputs(const RemoteJob &Remote);
+
+    QTcpServer Server;
+
+    QString Token;
+
+    QList<RemoteWorker*> Workers;
+
+    QMap<QString, RemoteJob> Jobs;
+
+    // Packaged outputs received from workers (so identical outputs never have to be sent twice).
+    ContentStore Store;
+};
+
+#endif // BUILDCOORDINATOR_H
@@ -1,5 +1,8 @@
 #include "builderrordialog.h"
 #include "ui_builderrordialog.h"
+#include <QTextBlock>
+#include <QTextDocument>
+#include <QTextCursor>
 
 BuildErrorDialog::BuildErrorDialog(QWidget *parent) :
     QDialog(parent),
@@ -11,7 +14,28 @@ BuildErrorDialog::BuildErrorDialog(QWidget *parent) :
 BuildErrorDialog::BuildErrorDialog(QWidget *parent, QString Error) :
     BuildErrorDialog(parent)
 {
-    ui->errorText->setText(Error);
+    // Logs are always plain text - letting it guess could turn them into rich text, after which the blocks no longer line up with the log's lines.
+    ui->errorText->setPlainText(Error);
+}
+
+void BuildErrorDialog::SetHeading(QString Heading)
+{
+    ui->label->setText(Heading);
+}
+
+void BuildErrorDialog::ShowLine(int Line)
+{
+    QTextBlock Block = ui->errorText->document()->findBlockByNumber(Line);
+    if (!Block.isValid())
+    {
+        return;
+    }
+
+    // Select the whole line so it stands out, and make sure it's in view.
+    QTextCursor Cursor(Block);
+    Cursor.movePosition(QTextCursor::EndOfBlock, QTextCursor::KeepAnchor);
+    ui->errorText->setTextCursor(Cursor);
+    ui->errorText->ensureCursorVisible();
 }
 
 BuildErrorDialog::~BuildErrorDialog()
@@ -16,6 +16,12 @@ public:
     BuildErrorDialog(QWidget *parent, QString Error);
     ~BuildErrorDialog();
 
+    // Replace the text above the log (eg. when showing a log that didn't fail).
+    void SetHeading(QString Heading);
+
+    // Scroll to & highlight a (zero based) line of the log.
+    void ShowLine(int Line);
+
 private:
     Ui::BuildErrorDialog *ui;
 };
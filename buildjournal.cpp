@@ -0,0 +1,236 @@
+#include "buildjournal.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QJsonDocument>
+#include <QUuid>
+#include <QMap>
+
+#include "processtree.h"
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+BuildJournal::BuildJournal() :
+    BuildJournal(QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/BuildJournal.jsonl")
+{
+}
+
+BuildJournal::BuildJournal(QString Path)
+{
+    JournalPath = Path;
+    JournalFile.setFileName(JournalPath);
+
+    // Make sure the data directory exists, as it won't on a fresh install.
+    QDir().mkpath(QFileInfo(JournalPath).absolutePath());
+}
+
+BuildJournal::~BuildJournal()
+{
+    JournalFile.close();
+}
+
+QList<BuildJob> BuildJournal::Recover()
+{
+    // Jobs are kept in a map for easy lookup, with a seperate list to remember the order they were submitted in.
+    QMap<QString, BuildJob> Jobs;
+    QMap<QString, QString> States;
+    QStringList Order;
+
+    QFile ExistingJournal(JournalPath);
+    if (ExistingJournal.open(QFile::ReadOnly | QFile::Text))
+    {
+        while (!ExistingJournal.atEnd())
+        {
+            QByteArray Line = ExistingJournal.readLine().trimmed();
+
+            // A crash can leave a half written record at the end of the journal, so just skip anything that doesn't parse.
+            QJsonParseError ParseError;
+            QJsonObject Record = QJsonDocument::fromJson(Line, &ParseError).object();
+            if (ParseError.error != QJsonParseError::NoError || !Record.contains("id"))
+            {
+#ifdef QT_DEBUG
+                qDebug() << "Skipping Invalid Build Journal Record: " << Line;
+#endif
+                continue;
+            }
+
+            QString Id = Record["id"].toString();
+            QString State = Record["state"].toString();
+
+            if (State == "submitted")
+            {
+                BuildJob Job;
+                Job.Id = Id;
+                Job.PluginPath = Record["plugin"].toString();
+                Job.EngineName = Record["engineName"].toString();
+                Job.EnginePath = Record["enginePath"].toString();
+
+                Jobs.insert(Id, Job);
+                Order.append(Id);
+            }
+            else if (!Jobs.contains(Id))
+            {
+                // A transition for a job we never saw being submitted (eg. a torn submission record), so nothing to resume.
+                continue;
+            }
+            else if (State == "started")
+            {
+                Jobs[Id].Target = Record["target"].toString();
+                Jobs[Id].ProcessId = static_cast<qint64>(Record["pid"].toDouble());
+                Jobs[Id].ProcessStartTime = Record["startTime"].toString();
+            }
+
+            States.insert(Id, State);
+        }
+        ExistingJournal.close();
+    }
+
+    QList<BuildJob> Unfinished;
+    for (QString Id : Order)
+    {
+        QString State = States.value(Id);
+        if (State != "submitted" && State != "started")
+        {
+            // Already finished or cancelled.
+            continue;
+        }
+
+        BuildJob Job = Jobs.value(Id);
+
+        // The previous session died while UAT was still running - we can't hook a QProcess back up to it, so kill it and build it again from scratch.
+        if (State == "started" && Job.ProcessId > 0)
+        {
+            if (KillOrphanedProcess(Job))
+            {
+#ifdef QT_DEBUG
+                qDebug() << "Killed Orphaned UAT Process " << Job.ProcessId << " For Plugin " << Job.PluginPath;
+#endif
+            }
+        }
+
+        // It'll be restarted, so forget about the old run.
+        Job.Target.clear();
+        Job.ProcessId = 0;
+        Job.ProcessStartTime.clear();
+
+        Unfinished.append(Job);
+    }
+
+    // Compact the journal down to just the unfinished jobs so it doesn't grow forever. QSaveFile makes sure we either get the old or the new journal, never half of one.
+    QSaveFile CompactedJournal(JournalPath);
+    if (CompactedJournal.open(QFile::WriteOnly | QFile::Text))
+    {
+        for (BuildJob Job : Unfinished)
+        {
+            QJsonObject Record;
+            Record["id"] = Job.Id;
+            Record["state"] = "submitted";
+            Record["plugin"] = Job.PluginPath;
+            Record["engineName"] = Job.EngineName;
+            Record["enginePath"] = Job.EnginePath;
+
+            CompactedJournal.write(QJsonDocument(Record).toJson(QJsonDocument::Compact) + "\n");
+        }
+
+        if (!CompactedJournal.commit())
+        {
+#ifdef QT_DEBUG
+            qDebug() << "Unable To Compact Build Journal @ " << JournalPath;
+#endif
+        }
+    }
+
+    return Unfinished;
+}
+
+bool BuildJournal::Submit(BuildJob &Job)
+{
+    Job.Id = QUuid::createUuid().toString();
+
+    QJsonObject Record;
+    Record["id"] = Job.Id;
+    Record["state"] = "submitted";
+    Record["plugin"] = Job.PluginPath;
+    Record["engineName"] = Job.EngineName;
+    Record["enginePath"] = Job.EnginePath;
+
+    return Append(Record);
+}
+
+bool BuildJournal::MarkStarted(const BuildJob &Job)
+{
+    QJsonObject Record;
+    Record["id"] = Job.Id;
+    Record["state"] = "started";
+    Record["target"] = Job.Target;
+    Record["pid"] = static_cast<double>(Job.ProcessId);
+    Record["startTime"] = Job.ProcessStartTime;
+
+    return Append(Record);
+}
+
+bool BuildJournal::MarkFinished(QString Id, bool bSucceeded)
+{
+    QJsonObject Record;
+    Record["id"] = Id;
+    Record["state"] = bSucceeded ? "succeeded" : "failed";
+
+    return Append(Record);
+}
+
+bool BuildJournal::MarkCancelled(QString Id)
+{
+    QJsonObject Record;
+    Record["id"] = Id;
+    Record["state"] = "cancelled";
+
+    return Append(Record);
+}
+
+bool BuildJournal::Append(QJsonObject Record)
+{
+    if (!JournalFile.isOpen() && !JournalFile.open(QFile::WriteOnly | QFile::Append | QFile::Text))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Open Build Journal @ " << JournalPath;
+#endif
+        return false;
+    }
+
+    // One record per line, so a torn write can only ever damage the last record.
+    QByteArray Line = QJsonDocument(Record).toJson(QJsonDocument::Compact) + "\n";
+    if (JournalFile.write(Line) != Line.size() || !JournalFile.flush())
+    {
+        return false;
+    }
+
+    // Flushing only gets it to the OS - make sure it is actually on disk in case the machine itself goes down.
+#ifdef Q_OS_WIN
+    return _commit(JournalFile.handle()) == 0;
+#else
+    return fsync(JournalFile.handle()) == 0;
+#endif
+}
+
+bool BuildJournal::KillOrphanedProcess(const BuildJob &Job)
+{
+    /// NOTE: PIDs get reused (freely so after a reboot), so only kill the process if it's still the one we started & still looks like UAT, to avoid taking down something unrelated.
+    if (Job.ProcessStartTime.isEmpty() || ProcessTree::GetStartTime(Job.ProcessId) != Job.ProcessStartTime)
+    {
+        // Either it's already gone, or the PID belongs to something else now.
+        return false;
+    }
+
+    if (!ProcessTree::ReadCommandLine(Job.ProcessId).contains("RunUAT"))
+    {
+        return false;
+    }
+
+    return ProcessTree::Kill(Job.ProcessId);
+}
@@ -0,0 +1,65 @@
+#ifndef BUILDJOURNAL_H
+#define BUILDJOURNAL_H
+
+#include <QObject>
+#include <QFile>
+#include <QList>
+#include <QJsonObject>
+
+// A single plugin build as it is tracked by the journal (and the build queue).
+struct BuildJob
+{
+    QString Id;
+    QString PluginPath;
+    QString EngineName;
+    QString EnginePath;
+
+    // Only known once the job has actually been started.
+    QString Target;
+    qint64 ProcessId = 0;
+    QString ProcessStartTime;
+
+    // Read from the plugin when its target is resolved (so the retention manager knows what's in the output).
+    QString PluginName;
+    QString PluginVersion;
+};
+
+class BuildJournal
+{
+public:
+    // Use the default journal location inside of uPBT's data directory.
+    BuildJournal();
+
+    BuildJournal(QString Path);
+
+    ~BuildJournal();
+
+    // Replay the journal, clean up any UAT processes the previous session left behind and return the jobs that never finished (in submission order).
+    /// NOTE: This also compacts the journal down to just those unfinished jobs, so it should only be called once on startup.
+    QList<BuildJob> Recover();
+
+    // Record a newly queued job. Assigns the job its ID.
+    bool Submit(BuildJob &Job);
+
+    // Record that a job's UAT process has been launched (including its target, PID & the PID's start time so it can be cleaned up if we crash).
+    bool MarkStarted(const BuildJob &Job);
+
+    // Record that a job has finished (either successfully or not) so it won't be resumed.
+    bool MarkFinished(QString Id, bool bSucceeded);
+
+    // Record that the user doesn't want this job anymore.
+    bool MarkCancelled(QString Id);
+
+private:
+    // Append a record to the journal and make sure it actually hit the disk before returning.
+    bool Append(QJsonObject Record);
+
+    // Whether a (previous session's) UAT process is still running, and if so kill it and its children.
+    static bool KillOrphanedProcess(const BuildJob &Job);
+
+    QString JournalPath;
+
+    QFile JournalFile;
+};
+
+#endif // BUILDJOURNAL_H
@@ -0,0 +1,492 @@
+#include "buildlogindex.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QDir>
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QRegularExpression>
+#include <QMap>
+
+#include <algorithm>
+#include <iterator>
+
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// How many lines go into each seperately compressed frame of a stored log.
+static const int LogFrameLines = 256;
+
+// Identifies a stored log file ("uPBL") & the version of its layout.
+static const quint32 LogMagic = 0x7550424C;
+static const quint32 LogVersion = 1;
+
+BuildLogIndex::BuildLogIndex() :
+    BuildLogIndex(QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/BuildLogs")
+{
+}
+
+BuildLogIndex::BuildLogIndex(QString Path)
+{
+    LogsPath = Path;
+    IndexPath = LogsPath + "/Index.dat";
+
+    QDir().mkpath(LogsPath);
+
+    // Get the index loaded (and any damage from a crash repaired) straight away, so it's ready by the time anyone searches.
+    bActive = true;
+    start(QThread::LowPriority);
+}
+
+BuildLogIndex::~BuildLogIndex()
+{
+    // Stop loading, but still store any logs that are waiting so they don't get lost.
+    requestInterruption();
+    wait();
+}
+
+void BuildLogIndex::AddLog(const BuildJob &Job, bool bSucceeded, QString OutputLog)
+{
+    PendingLog Log;
+    Log.Job = Job;
+    Log.bSucceeded = bSucceeded;
+    Log.OutputLog = OutputLog;
+
+    QMutexLocker Lock(&Mutex);
+    PendingLogs.append(Log);
+
+    if (bActive)
+    {
+        // The running thread will pick it up once it's done.
+        return;
+    }
+
+    bActive = true;
+    Lock.unlock();
+
+    // The previous run may still be on its way out.
+    wait();
+    start(QThread::LowPriority);
+}
+
+bool BuildLogIndex::IsLoaded()
+{
+    QMutexLocker Lock(&Mutex);
+    return bLoaded;
+}
+
+void BuildLogIndex::run()
+{
+    QMutexLocker Lock(&Mutex);
+    bool bNeedsLoad = !bLoaded;
+    Lock.unlock();
+
+    if (bNeedsLoad)
+    {
+        // This has to happen before anything else gets appended to the index.
+        ValidateIndex();
+        Load();
+    }
+
+    forever
+    {
+        Lock.relock();
+        if (PendingLogs.isEmpty())
+        {
+            bActive = false;
+            return;
+        }
+
+        PendingLog Log = PendingLogs.takeFirst();
+        Lock.unlock();
+
+        StoreLog(Log);
+    }
+}
+
+bool BuildLogIndex::StoreLog(const PendingLog &Log)
+{
+    LogInfo Info;
+    Info.PluginPath = Log.Job.PluginPath;
+    Info.EngineName = Log.Job.EngineName;
+    Info.Time = QDateTime::currentDateTime();
+    Info.bSucceeded = Log.bSucceeded;
+
+    // The same job can be built more than once (eg. when it's resumed), so tack the time on to keep every run's log.
+    Info.Id = QString(Log.Job.Id).remove('{').remove('}') + "-" + QString::number(Info.Time.toMSecsSinceEpoch());
+
+    QStringList Lines = Log.OutputLog.split('\n');
+    for (QString &Line : Lines)
+    {
+        if (Line.endsWith('\r'))
+        {
+            Line.chop(1);
+        }
+    }
+
+    // Compress the log frame by frame, remembering where each frame starts (relative to the end of the header) so we can seek to it later.
+    QByteArray Frames;
+    QDataStream FrameStream(&Frames, QIODevice::WriteOnly);
+    FrameStream.setVersion(QDataStream::Qt_5_7);
+
+    QVector<quint32> FirstLines;
+    QVector<qint64> Offsets;
+    for (int FirstLine = 0; FirstLine < Lines.size(); FirstLine += LogFrameLines)
+    {
+        FirstLines.append(FirstLine);
+        Offsets.append(Frames.size());
+        FrameStream << qCompress(Lines.mid(FirstLine, LogFrameLines).join('\n').toUtf8());
+    }
+
+    QSaveFile LogFile(GetLogPath(Info.Id));
+    if (!LogFile.open(QFile::WriteOnly))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Store Build Log @ " << LogFile.fileName();
+#endif
+        return false;
+    }
+
+    QDataStream LogStream(&LogFile);
+    LogStream.setVersion(QDataStream::Qt_5_7);
+    LogStream << LogMagic << LogVersion << FirstLines << Offsets;
+    LogFile.write(Frames);
+
+    if (!LogFile.commit())
+    {
+        return false;
+    }
+
+    // Work out which lines each token appears on.
+    QHash<QString, QVector<quint32>> TokenLines;
+    for (int i = 0; i < Lines.size(); i++)
+    {
+        for (QString Token : Tokenize(Lines[i]))
+        {
+            TokenLines[Token].append(i);
+        }
+    }
+
+    // Append the log's postings to the index as a single record, so a crash can only ever lose the last log.
+    QByteArray Record;
+    QDataStream RecordStream(&Record, QIODevice::WriteOnly);
+    RecordStream.setVersion(QDataStream::Qt_5_7);
+    RecordStream << Info.Id << Info.PluginPath << Info.EngineName << Info.Time << Info.bSucceeded << TokenLines;
+
+    QFile Index(IndexPath);
+    if (!Index.open(QFile::WriteOnly | QFile::Append))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Open Build Log Index @ " << IndexPath;
+#endif
+        return false;
+    }
+
+    QDataStream IndexStream(&Index);
+    IndexStream.setVersion(QDataStream::Qt_5_7);
+    IndexStream << Record;
+
+    if (!Index.flush())
+    {
+        return false;
+    }
+
+    // Flushing only gets it to the OS - make sure it is actually on disk, so a crash can't tear this record & take the ones after it down too.
+#ifdef Q_OS_WIN
+    bool bSynced = _commit(Index.handle()) == 0;
+#else
+    bool bSynced = fsync(Index.handle()) == 0;
+#endif
+
+    // If the index hasn't been loaded (eg. because loading was interrupted), this log will get picked up when it is.
+    QMutexLocker Lock(&Mutex);
+    if (bLoaded)
+    {
+        Logs.append(Info);
+        AddPostings(Postings, Logs.size() - 1, TokenLines);
+    }
+
+    return bSynced;
+}
+
+QList<BuildLogHit> BuildLogIndex::Search(QString Query, int MaxHits)
+{
+    QList<BuildLogHit> Hits;
+
+    QStringList Tokens = Tokenize(Query);
+    if (Tokens.isEmpty())
+    {
+        return Hits;
+    }
+
+    QMutexLocker Lock(&Mutex);
+    if (!bLoaded)
+    {
+        return Hits;
+    }
+
+    // Start with the rarest token so the intersection stays as small as possible.
+    std::sort(Tokens.begin(), Tokens.end(), [this](const QString &A, const QString &B) { return Postings.value(A).size() < Postings.value(B).size(); });
+
+    QVector<quint64> Matches = Postings.value(Tokens[0]);
+    for (int i = 1; i < Tokens.size() && !Matches.isEmpty(); i++)
+    {
+        QVector<quint64> TokenMatches = Postings.value(Tokens[i]);
+
+        QVector<quint64> Intersection;
+        std::set_intersection(Matches.begin(), Matches.end(), TokenMatches.begin(), TokenMatches.end(), std::back_inserter(Intersection));
+        Matches = Intersection;
+    }
+
+    // Newest logs first, as those are most likely to be relevant.
+    for (int i = Matches.size() - 1; i >= 0 && Hits.size() < MaxHits; i--)
+    {
+        const LogInfo &Info = Logs[int(Matches[i] >> 32)];
+
+        BuildLogHit Hit;
+        Hit.LogId = Info.Id;
+        Hit.PluginPath = Info.PluginPath;
+        Hit.EngineName = Info.EngineName;
+        Hit.Time = Info.Time;
+        Hit.bSucceeded = Info.bSucceeded;
+        Hit.Line = int(Matches[i] & 0xFFFFFFFF);
+
+        Hits.append(Hit);
+    }
+
+    // Reading the lines back doesn't touch the in memory index, so don't hold up the indexing thread while doing so.
+    Lock.unlock();
+
+    // Decompressed frames, by log & first line, so hits close together don't decompress the same frame over and over.
+    QHash<QString, QMap<int, QStringList>> FrameCache;
+
+    for (BuildLogHit &Hit : Hits)
+    {
+        QMap<int, QStringList> &Frames = FrameCache[Hit.LogId];
+        QMap<int, QStringList>::iterator Frame = Frames.upperBound(Hit.Line);
+        if (Frame != Frames.begin())
+        {
+            --Frame;
+        }
+
+        if (Frame == Frames.end() || Frame.key() > Hit.Line || Hit.Line - Frame.key() >= Frame.value().size())
+        {
+            int FirstLine = 0;
+            QStringList FrameLines = ReadFrame(Hit.LogId, Hit.Line, FirstLine);
+            Frame = Frames.insert(FirstLine, FrameLines);
+        }
+
+        Hit.Text = Frame.value().value(Hit.Line - Frame.key());
+    }
+
+    return Hits;
+}
+
+QString BuildLogIndex::ReadLog(QString LogId)
+{
+    QFile LogFile(GetLogPath(LogId));
+    if (!LogFile.open(QFile::ReadOnly))
+    {
+        return QString();
+    }
+
+    QDataStream LogStream(&LogFile);
+    LogStream.setVersion(QDataStream::Qt_5_7);
+
+    quint32 Magic, Version;
+    QVector<quint32> FirstLines;
+    QVector<qint64> Offsets;
+    LogStream >> Magic >> Version >> FirstLines >> Offsets;
+
+    if (Magic != LogMagic || Version != LogVersion)
+    {
+        return QString();
+    }
+
+    // The frames are stored back to back, so just decompress all of them in order.
+    QStringList Frames;
+    for (int i = 0; i < FirstLines.size(); i++)
+    {
+        QByteArray Frame;
+        LogStream >> Frame;
+        Frames.append(QString::fromUtf8(qUncompress(Frame)));
+    }
+
+    return Frames.join('\n');
+}
+
+QStringList BuildLogIndex::Tokenize(QString Line)
+{
+    QStringList Tokens;
+
+    // Anything that isn't part of a symbol, file name or error code splits tokens - so paths end up as their individual components.
+    /// NOTE: Static as this runs for every line of every log, and compiling the expression each time would dominate indexing.
+    static const QRegularExpression Separators("[^a-z0-9_.]+");
+
+    // Empty parts are dropped along with any other too short tokens below.
+    for (QString Token : Line.toLower().split(Separators))
+    {
+        // Get rid of any dots that are just punctuation (eg. the end of a sentence).
+        while (Token.startsWith('.'))
+        {
+            Token.remove(0, 1);
+        }
+
+        while (Token.endsWith('.'))
+        {
+            Token.chop(1);
+        }
+
+        if (Token.length() < 2 || Tokens.contains(Token))
+        {
+            continue;
+        }
+
+        Tokens.append(Token);
+    }
+
+    return Tokens;
+}
+
+void BuildLogIndex::ValidateIndex()
+{
+    QFile Index(IndexPath);
+    if (!Index.open(QFile::ReadWrite))
+    {
+        // No logs have been stored yet.
+        return;
+    }
+
+    QDataStream IndexStream(&Index);
+    IndexStream.setVersion(QDataStream::Qt_5_7);
+
+    // Every record is a byte array, so it starts with its length - hop from one to the next to find where the last complete one ends, without parsing any of them.
+    qint64 ValidSize = 0;
+    while (ValidSize < Index.size() && Index.seek(ValidSize))
+    {
+        quint32 Length;
+        IndexStream >> Length;
+
+        if (IndexStream.status() != QDataStream::Ok || Length == 0xFFFFFFFF || ValidSize + qint64(sizeof(quint32)) + Length > Index.size())
+        {
+            break;
+        }
+
+        ValidSize += qint64(sizeof(quint32)) + Length;
+    }
+
+    if (ValidSize < Index.size())
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Truncating Corrupted Build Log Index From " << Index.size() << " To " << ValidSize << " Bytes.";
+#endif
+        Index.resize(ValidSize);
+    }
+}
+
+void BuildLogIndex::Load()
+{
+    QList<LogInfo> LoadedLogs;
+    QHash<QString, QVector<quint64>> LoadedPostings;
+
+    QFile Index(IndexPath);
+    if (Index.open(QFile::ReadOnly))
+    {
+        QDataStream IndexStream(&Index);
+        IndexStream.setVersion(QDataStream::Qt_5_7);
+
+        while (!IndexStream.atEnd())
+        {
+            if (isInterruptionRequested())
+            {
+                return;
+            }
+
+            QByteArray Record;
+            IndexStream >> Record;
+
+            if (IndexStream.status() != QDataStream::Ok)
+            {
+                break;
+            }
+
+            QDataStream RecordStream(Record);
+            RecordStream.setVersion(QDataStream::Qt_5_7);
+
+            LogInfo Info;
+            QHash<QString, QVector<quint32>> TokenLines;
+            RecordStream >> Info.Id >> Info.PluginPath >> Info.EngineName >> Info.Time >> Info.bSucceeded >> TokenLines;
+
+            if (RecordStream.status() != QDataStream::Ok)
+            {
+                // The records around it are still intact, so just leave this one out.
+                continue;
+            }
+
+            LoadedLogs.append(Info);
+            AddPostings(LoadedPostings, LoadedLogs.size() - 1, TokenLines);
+        }
+    }
+
+    QMutexLocker Lock(&Mutex);
+    Logs = LoadedLogs;
+    Postings = LoadedPostings;
+    bLoaded = true;
+}
+
+void BuildLogIndex::AddPostings(QHash<QString, QVector<quint64>> &TargetPostings, quint32 LogNumber, QHash<QString, QVector<quint32>> TokenLines)
+{
+    // Logs are added in order & their lines are in order, so simply appending keeps every posting list sorted.
+    for (QHash<QString, QVector<quint32>>::const_iterator It = TokenLines.constBegin(); It != TokenLines.constEnd(); ++It)
+    {
+        QVector<quint64> &TokenPostings = TargetPostings[It.key()];
+        for (quint32 Line : It.value())
+        {
+            TokenPostings.append((quint64(LogNumber) << 32) | Line);
+        }
+    }
+}
+
+QStringList BuildLogIndex::ReadFrame(QString LogId, int Line, int &FirstLine)
+{
+    QFile LogFile(GetLogPath(LogId));
+    if (!LogFile.open(QFile::ReadOnly))
+    {
+        return QStringList();
+    }
+
+    QDataStream LogStream(&LogFile);
+    LogStream.setVersion(QDataStream::Qt_5_7);
+
+    quint32 Magic, Version;
+    QVector<quint32> FirstLines;
+    QVector<qint64> Offsets;
+    LogStream >> Magic >> Version >> FirstLines >> Offsets;
+
+    if (Magic != LogMagic || Version != LogVersion || FirstLines.isEmpty() || FirstLines.size() != Offsets.size())
+    {
+        return QStringList();
+    }
+
+    // Find the last frame that starts at or before the line, and jump straight to it.
+    int FrameIndex = int(std::upper_bound(FirstLines.begin(), FirstLines.end(), quint32(Line)) - FirstLines.begin()) - 1;
+    FirstLine = int(FirstLines[qMax(0, FrameIndex)]);
+
+    if (!LogFile.seek(LogFile.pos() + Offsets[qMax(0, FrameIndex)]))
+    {
+        return QStringList();
+    }
+
+    QByteArray Frame;
+    LogStream >> Frame;
+
+    return QString::fromUtf8(qUncompress(Frame)).split('\n');
+}
+
+QString BuildLogIndex::GetLogPath(QString LogId)
+{
+    return LogsPath + "/" + LogId + ".log";
+}
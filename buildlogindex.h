@@ -0,0 +1,111 @@
+#ifndef BUILDLOGINDEX_H
+#define BUILDLOGINDEX_H
+
+#include <QThread>
+#include <QMutex>
+#include <QDateTime>
+#include <QHash>
+#include <QVector>
+
+#include "buildjournal.h"
+
+// A single line (of a stored build log) that matched a search.
+struct BuildLogHit
+{
+    QString LogId;
+    QString PluginPath;
+    QString EngineName;
+    QDateTime Time;
+    bool bSucceeded = false;
+
+    // Zero based line number within the log.
+    int Line = 0;
+    QString Text;
+};
+
+// Keeps every build's output log (compressed) & an inverted index of the tokens in them, so old failures can be looked up again.
+/// NOTE: Logs are stored in frames of lines that are compressed seperately, so a single line can be read back without decompressing the whole log.
+/// NOTE: Loading the index & storing new logs happens on a background thread, so neither holds up the UI.
+class BuildLogIndex : public QThread
+{
+    Q_OBJECT
+
+public:
+    // Use the default log directory inside of uPBT's data directory.
+    BuildLogIndex();
+
+    BuildLogIndex(QString Path);
+    ~BuildLogIndex();
+
+    // Queue the job's log to be compressed, stored & indexed in the background.
+    void AddLog(const BuildJob &Job, bool bSucceeded, QString OutputLog);
+
+    // Whether the index has been loaded yet (searches won't find anything until it has).
+    bool IsLoaded();
+
+    // Find the lines that contain all of the query's tokens (eg. "C4668 Foo.h"), newest logs first.
+    QList<BuildLogHit> Search(QString Query, int MaxHits = 500);
+
+    QString ReadLog(QString LogId);
+
+    // Split a line up into (lower case) error codes, symbol names, file names, etc.
+    static QStringList Tokenize(QString Line);
+
+protected:
+    void run() override;
+
+private:
+    struct LogInfo
+    {
+        QString Id;
+        QString PluginPath;
+        QString EngineName;
+        QDateTime Time;
+        bool bSucceeded = false;
+    };
+
+    // A log that's waiting to be stored.
+    struct PendingLog
+    {
+        BuildJob Job;
+        bool bSucceeded;
+        QString OutputLog;
+    };
+
+    // Chop off whatever a crash left half written at the end of the index, as every record appended after it would be unreadable.
+    void ValidateIndex();
+
+    // Read the index from disk (gives up if the thread is interrupted, leaving the index unloaded).
+    void Load();
+
+    // Compress & store a log, and append its postings to the index.
+    bool StoreLog(const PendingLog &Log);
+
+    // Add a log's postings to an in memory index.
+    static void AddPostings(QHash<QString, QVector<quint64>> &TargetPostings, quint32 LogNumber, QHash<QString, QVector<quint32>> TokenLines);
+
+    // Decompress the frame of the log that contains the line, returning the frame's lines & its first line number.
+    QStringList ReadFrame(QString LogId, int Line, int &FirstLine);
+
+    QString GetLogPath(QString LogId);
+
+    QString LogsPath;
+
+    QString IndexPath;
+
+    // Guards everything below, as it's shared between the UI & indexing threads.
+    QMutex Mutex;
+
+    QList<PendingLog> PendingLogs;
+
+    bool bActive = false;
+
+    bool bLoaded = false;
+
+    QList<LogInfo> Logs;
+
+    // Every line a token appears on, packed as (log number << 32 | line number) & kept sorted so lookups can be intersected quickly.
+    QHash<QString, QVector<quint64>> Postings;
+};
+
+#endif // BUILDLOGINDEX_H
@@ -0,0 +1,310 @@
+#include "buildworker.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QTimer>
+#include <QTcpSocket>
+
+#include "processtree.h"
+
+// Only send back the end of huge build logs (that's where the errors are anyway), so the result always fits in a single message.
+static const int MaxLogLength = 16 * 1024 * 1024;
+
+// Whether a name from the coordinator is a single path component, so it can't be used to escape the job's work dir.
+static bool IsSafeFileName(QString Name)
+{
+    return ContentStore::IsSafeRelativePath(Name) && !Name.contains('/') && !Name.contains('\\') && Name != ".";
+}
+
+BuildWorker::BuildWorker(QList<UnrealInstall> Installs, int Capacity, QString Token, qint64 StoreLimit, QObject *parent) :
+    QObject(parent),
+    Installs(Installs),
+    Capacity(Capacity),
+    Token(Token),
+    StoreLimit(StoreLimit),
+    Store(QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/WorkerStore")
+{
+}
+
+BuildWorker::~BuildWorker()
+{
+    for (WorkerJob *Job : Jobs.values())
+    {
+        RemoveJob(Job);
+    }
+}
+
+void BuildWorker::Connect(QString Host, quint16 Port)
+{
+    CoordinatorHost = Host;
+    CoordinatorPort = Port;
+
+    QTcpSocket *Socket = new QTcpSocket();
+    Connection = new BuildConnection(Socket, this);
+
+    connect(Socket, &QTcpSocket::connected, this, &BuildWorker::on_Connection_connected);
+    connect(Connection, &BuildConnection::MessageReceived, this, &BuildWorker::on_Connection_message);
+    connect(Connection, &BuildConnection::Disconnected, this, &BuildWorker::on_Connection_disconnected);
+    connect(Connection, &BuildConnection::BlobsSent, this, &BuildWorker::on_Connection_blobsSent);
+
+    // A refused connection never counts as a disconnect, so handle errors the same way to keep on retrying.
+#if QT_VERSION >= QT_VERSION_CHECK(5, 15, 0)
+    connect(Socket, &QAbstractSocket::errorOccurred, this, &BuildWorker::on_Connection_disconnected);
+#else
+    connect(Socket, QOverload<QAbstractSocket::SocketError>::of(&QAbstractSocket::error), this, &BuildWorker::on_Connection_disconnected);
+#endif
+
+    qDebug() << "Connecting To Build Coordinator @ " << Host << ":" << Port << "...";
+    Socket->connectToHost(Host, Port);
+}
+
+void BuildWorker::on_Connection_connected()
+{
+    qDebug() << "Connected To Build Coordinator, Advertising " << Installs.size() << " Engine Install(s).";
+
+    // Tell the coordinator which engines we have & how many builds we're willing to run at once.
+    QVariantList Engines;
+    for (UnrealInstall Install : Installs)
+    {
+        // Send the version too, as the names of custom installs are rarely unique.
+        QVariantMap Engine;
+        Engine["name"] = Install.GetName();
+        Engine["version"] = Install.GetVersion();
+        Engines.append(Engine);
+    }
+
+    QVariantMap Hello;
+    Hello["type"] = "hello";
+    Hello["token"] = Token;
+    Hello["engines"] = Engines;
+    Hello["capacity"] = Capacity;
+    Connection->Send(Hello);
+}
+
+void BuildWorker::on_Connection_message(QVariantMap Message)
+{
+    QString Type = Message["type"].toString();
+
+    if (Type == "job")
+    {
+        ReceiveJob(Message);
+        return;
+    }
+
+    WorkerJob *Job = Jobs.value(Message["job"].toString());
+    if (!Job)
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Received " << Type << " Message For Unknown Job " << Message["job"].toString();
+#endif
+        return;
+    }
+
+    if (Type == "chunk")
+    {
+        if (!Store.ReceiveChunk(Job->Id, Message["hash"].toString(), Message["data"].toByteArray(), Message["final"].toBool()))
+        {
+            Job->bSourcesValid = false;
+        }
+    }
+    else if (Type == "blobs")
+    {
+        // The coordinator has sent over all of the sources we were missing.
+        if (!Job->bSourcesValid)
+        {
+            FailJob(Job, "Worker received corrupted plugin sources.");
+            return;
+        }
+
+        StartJob(Job);
+    }
+    else if (Type == "need")
+    {
+        // The coordinator wants the packaged outputs it doesn't have yet - once they've been sent, we're done with this job.
+        Connection->SendBlobs(Job->Id, Message["hashes"].toStringList(), Job->OutputPaths);
+    }
+}
+
+void BuildWorker::on_Connection_blobsSent(QString JobId)
+{
+    // Sources are sent the other way, so this is always a job's outputs (which are read from its work dir until now).
+    WorkerJob *Job = Jobs.value(JobId);
+    if (Job)
+    {
+        RemoveJob(Job);
+    }
+}
+
+void BuildWorker::on_Connection_disconnected()
+{
+    if (!Connection)
+    {
+        // Already handled (errors & disconnects can both fire for the same connection).
+        return;
+    }
+
+    qDebug() << "Lost Connection To Build Coordinator....Retrying In 5 Seconds.";
+
+    // The coordinator requeues whatever we were building, so there's no point in finishing any of it.
+    for (WorkerJob *Job : Jobs.values())
+    {
+        RemoveJob(Job);
+    }
+
+    Connection->deleteLater();
+    Connection = nullptr;
+
+    QTimer::singleShot(5000, this, [this]() { Connect(CoordinatorHost, CoordinatorPort); });
+}
+
+void BuildWorker::ReceiveJob(QVariantMap Message)
+{
+    if (Jobs.contains(Message["job"].toString()))
+    {
+        return;
+    }
+
+    WorkerJob *Job = new WorkerJob();
+    Job->Id = Message["job"].toString();
+    Job->EngineName = Message["engine"].toString();
+    Job->EngineVersion = Message["engineVersion"].toString();
+    Job->PluginDir = Message["pluginDir"].toString();
+    Job->PluginFile = Message["pluginFile"].toString();
+    Job->SourceManifest = Message["manifest"].toList();
+    Job->WorkDir = new QTemporaryDir();
+
+    Jobs.insert(Job->Id, Job);
+
+    qDebug() << "Received Job " << Job->Id << " To Build " << Job->PluginFile << " For " << Job->EngineName;
+
+    // These get joined onto the work dir, so make sure they can't point anywhere else.
+    if (!IsSafeFileName(Job->PluginDir) || !IsSafeFileName(Job->PluginFile) || !Job->PluginFile.endsWith(".uplugin"))
+    {
+        FailJob(Job, "Worker received an invalid plugin path.");
+        return;
+    }
+
+    // Ask for whichever sources we don't already have from previous builds (even if that's none, so the coordinator knows to go ahead).
+    QVariantMap Need;
+    Need["type"] = "need";
+    Need["job"] = Job->Id;
+    Need["hashes"] = Store.Missing(Job->SourceManifest);
+    Connection->Send(Need);
+}
+
+void BuildWorker::StartJob(WorkerJob *Job)
+{
+    UnrealInstall *EngineInstall = nullptr;
+    for (int i = 0; i < Installs.size(); i++)
+    {
+        if (UnrealInstall::IsSameEngine(Installs[i].GetName(), Installs[i].GetVersion(), Job->EngineName, Job->EngineVersion))
+        {
+            EngineInstall = &Installs[i];
+            break;
+        }
+    }
+
+    if (!EngineInstall)
+    {
+        FailJob(Job, QString("Worker doesn't have engine %1 (%2) installed.").arg(Job->EngineName, Job->EngineVersion.isEmpty() ? "unknown version" : Job->EngineVersion));
+        return;
+    }
+
+    QString PluginRoot = Job->WorkDir->path() + "/" + Job->PluginDir;
+    if (!Job->WorkDir->isValid() || !Store.Checkout(Job->SourceManifest, PluginRoot))
+    {
+        FailJob(Job, "Worker was unable to check out the plugin sources.");
+        return;
+    }
+
+    QString RunUATPath = EngineInstall->GetRunUATPath();
+    QStringList RunUATFlags;
+    RunUATFlags << "BuildPlugin";
+    RunUATFlags << "-Plugin=" + PluginRoot + "/" + Job->PluginFile;
+    RunUATFlags << "-Package=" + Job->WorkDir->path() + "/Package";
+    RunUATFlags << "-Rocket";
+
+#ifdef QT_DEBUG
+    qDebug() << "Going to run " << RunUATPath << " with the flags: " << RunUATFlags << " to build job " << Job->Id << "...";
+#endif
+
+    Job->Process = new QProcess(this);
+    Job->Process->setProcessChannelMode(QProcess::MergedChannels);
+
+    connect(Job->Process, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished), this, [this, Job](int exitCode, QProcess::ExitStatus exitStatus) { on_JobBuild_complete(Job, exitCode, exitStatus); });
+    Job->Process->start(RunUATPath, RunUATFlags);
+
+    if (!Job->Process->waitForStarted())
+    {
+        FailJob(Job, QString("Worker was unable to start UAT @ %1").arg(RunUATPath));
+    }
+}
+
+void BuildWorker::on_JobBuild_complete(WorkerJob *Job, int exitCode, QProcess::ExitStatus exitStatus)
+{
+    bool bSucceeded = exitStatus == QProcess::NormalExit && exitCode == 0;
+
+    QVariantMap Result;
+    Result["type"] = "result";
+    Result["job"] = Job->Id;
+    Result["success"] = bSucceeded;
+    Result["log"] = QString(Job->Process->readAll()).right(MaxLogLength);
+
+    // Only successful builds have outputs worth sending back.
+    if (bSucceeded)
+    {
+        Result["manifest"] = ContentStore::CreateManifest(Job->WorkDir->path() + "/Package", QStringList(), Job->OutputPaths);
+    }
+
+    Connection->Send(Result);
+
+    qDebug() << "Finished Job " << Job->Id << (bSucceeded ? " Successfully." : " But Failed.");
+
+    if (!bSucceeded)
+    {
+        RemoveJob(Job);
+    }
+}
+
+void BuildWorker::FailJob(WorkerJob *Job, QString Error)
+{
+    qDebug() << "Job " << Job->Id << " Failed: " << Error;
+
+    QVariantMap Result;
+    Result["type"] = "result";
+    Result["job"] = Job->Id;
+    Result["success"] = false;
+    Result["log"] = Error;
+    Connection->Send(Result);
+
+    RemoveJob(Job);
+}
+
+void BuildWorker::RemoveJob(WorkerJob *Job)
+{
+    Jobs.remove(Job->Id);
+    Store.Discard(Job->Id);
+
+    if (Job->Process)
+    {
+        // Stop listening first so killing UAT doesn't count as the build completing.
+        Job->Process->disconnect(this);
+
+        // Killing the process only stops the script, so take down UBT & the compilers it started too.
+        if (Job->Process->state() != QProcess::NotRunning)
+        {
+            ProcessTree::Kill(Job->Process->processId());
+        }
+        Job->Process->kill();
+        Job->Process->deleteLater();
+    }
+
+    // Deleting the temporary dir cleans up the sources & outputs too.
+    delete Job->WorkDir;
+    delete Job;
+
+    // Nothing is using the store right now, so it's safe to get rid of the sources that haven't been needed in the longest time.
+    if (Jobs.isEmpty())
+    {
+        Store.Trim(StoreLimit);
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef BUILDWORKER_H
+#define BUILDWORKER_H
+
+#include <QObject>
+#include <QMap>
+#include <QProcess>
+#include <QTemporaryDir>
+
+#include "unrealinstall.h"
+#include "buildconnection.h"
+#include "contentstore.h"
+
+// Runs headless (uPBT --worker <host>:<port>), connects to a coordinator and builds the plugins it gets sent using the local engine installs.
+class BuildWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    // The token has to match the coordinator's CoordinatorToken setting, or it'll refuse to send us anything.
+    /// NOTE: The store keeps sources around so they don't have to be sent again, and is trimmed down to StoreLimit bytes whenever the worker goes idle.
+    BuildWorker(QList<UnrealInstall> Installs, int Capacity, QString Token, qint64 StoreLimit, QObject *parent = 0);
+    ~BuildWorker();
+
+    // Connect (and keep reconnecting) to the coordinator.
+    void Connect(QString Host, quint16 Port);
+
+private:
+    // Everything we need to know about a job while it is being transferred & built.
+    struct WorkerJob
+    {
+        QString Id;
+        QString EngineName;
+        QString EngineVersion;
+        QString PluginDir;
+        QString PluginFile;
+        QVariantList SourceManifest;
+
+        // Cleared if any of the source chunks the coordinator sent couldn't be stored.
+        bool bSourcesValid = true;
+
+        QTemporaryDir *WorkDir = nullptr;
+        QProcess *Process = nullptr;
+
+        // Where each of the packaged output files lives (by hash) so they can be sent back.
+        QMap<QString, QString> OutputPaths;
+    };
+
+    void on_Connection_connected();
+
+    void on_Connection_message(QVariantMap Message);
+
+    void on_Connection_disconnected();
+
+    void on_Connection_blobsSent(QString JobId);
+
+    // The coordinator has sent us a new job's source manifest.
+    void ReceiveJob(QVariantMap Message);
+
+    // All of the job's sources are in the store, so check them out and start UAT.
+    void StartJob(WorkerJob *Job);
+
+    void on_JobBuild_complete(WorkerJob *Job, int exitCode, QProcess::ExitStatus exitStatus);
+
+    // Tell the coordinator the job failed without ever getting to run it.
+    void FailJob(WorkerJob *Job, QString Error);
+
+    void RemoveJob(WorkerJob *Job);
+
+    QList<UnrealInstall> Installs;
+
+    int Capacity;
+
+    QString Token;
+
+    qint64 StoreLimit;
+
+    QString CoordinatorHost;
+
+    quint16 CoordinatorPort;
+
+    BuildConnection *Connection = nullptr;
+
+    ContentStore Store;
+
+    QMap<QString, WorkerJob*> Jobs;
+};
+
+#endif // BUILDWORKER_H
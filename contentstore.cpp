@@ -0,0 +1,275 @@
+#include "contentstore.h"
+#include <QtDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QCryptographicHash>
+#include <QRegularExpression>
+#include <QDateTime>
+
+#include <algorithm>
+
+ContentStore::ContentStore(QString Path)
+{
+    StorePath = Path;
+    QDir().mkpath(StorePath);
+}
+
+ContentStore::~ContentStore()
+{
+    for (PendingBlob Blob : PendingBlobs)
+    {
+        // Deleting an uncommitted save file throws away what was written to it.
+        delete Blob.File;
+        delete Blob.Hash;
+    }
+}
+
+QVariantList ContentStore::CreateManifest(QString RootPath, QStringList ExcludedDirs, QMap<QString, QString> &PathsByHash)
+{
+    QVariantList Manifest;
+    QDir Root(RootPath);
+
+    QDirIterator It(RootPath, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+    while (It.hasNext())
+    {
+        QString FilePath = It.next();
+        QString RelativePath = Root.relativeFilePath(FilePath);
+
+        // Skip anything inside of an excluded directory (eg. Intermediate/Binaries for plugin sources)
+        bool bExcluded = false;
+        for (QString Dir : RelativePath.split('/').mid(0, RelativePath.count('/')))
+        {
+            if (ExcludedDirs.contains(Dir) || Dir.startsWith('.'))
+            {
+                bExcluded = true;
+                break;
+            }
+        }
+
+        if (bExcluded)
+        {
+            continue;
+        }
+
+        QFile File(FilePath);
+        if (!File.open(QFile::ReadOnly))
+        {
+#ifdef QT_DEBUG
+            qDebug() << "Unable To Read " << FilePath << " For Manifest....Skipping It!";
+#endif
+            continue;
+        }
+
+        // Hash the file in chunks so large binaries don't need to be loaded all at once.
+        QCryptographicHash Hash(QCryptographicHash::Sha256);
+        Hash.addData(&File);
+        QString FileHash = QString(Hash.result().toHex());
+
+        QVariantMap Entry;
+        Entry["path"] = RelativePath;
+        Entry["hash"] = FileHash;
+        Manifest.append(Entry);
+
+        PathsByHash.insert(FileHash, FilePath);
+    }
+
+    return Manifest;
+}
+
+bool ContentStore::IsSafeRelativePath(QString RelativePath)
+{
+    QString CleanPath = QDir::cleanPath(RelativePath);
+
+    // Colons would allow drive relative paths (eg. "C:foo") on Windows.
+    return !RelativePath.isEmpty() && !QDir::isAbsolutePath(RelativePath) && !RelativePath.contains(':') && CleanPath != ".." && !CleanPath.startsWith("../");
+}
+
+bool ContentStore::Contains(QString Hash)
+{
+    return QFileInfo::exists(GetBlobPath(Hash));
+}
+
+QStringList ContentStore::Missing(QVariantList Manifest)
+{
+    QStringList MissingHashes;
+
+    for (QVariant EntryVal : Manifest)
+    {
+        QString Hash = EntryVal.toMap()["hash"].toString();
+
+        // Files with the same contents only need to be sent once.
+        if (!MissingHashes.contains(Hash) && !Contains(Hash))
+        {
+            MissingHashes.append(Hash);
+        }
+    }
+
+    return MissingHashes;
+}
+
+bool ContentStore::ReceiveChunk(QString JobId, QString Hash, QByteArray CompressedData, bool bFinal)
+{
+    if (!IsValidHash(Hash))
+    {
+        return false;
+    }
+
+    QString Key = JobId + "/" + Hash;
+    if (!PendingBlobs.contains(Key))
+    {
+        QString BlobPath = GetBlobPath(Hash);
+        QDir().mkpath(QFileInfo(BlobPath).absolutePath());
+
+        // Use a save file so a half written blob never ends up in the store (several workers on one machine may share it).
+        PendingBlob Blob;
+        Blob.File = new QSaveFile(BlobPath);
+        Blob.Hash = new QCryptographicHash(QCryptographicHash::Sha256);
+
+        if (!Blob.File->open(QFile::WriteOnly))
+        {
+            delete Blob.File;
+            delete Blob.Hash;
+            return false;
+        }
+
+        PendingBlobs.insert(Key, Blob);
+    }
+
+    PendingBlob Blob = PendingBlobs.value(Key);
+
+    QByteArray Data = qUncompress(CompressedData);
+    Blob.Hash->addData(Data);
+    bool bWritten = Blob.File->write(Data) == Data.size();
+
+    if (bWritten && !bFinal)
+    {
+        return true;
+    }
+
+    PendingBlobs.remove(Key);
+
+    // Don't trust the sender - a corrupted blob would otherwise poison every future build that uses this hash.
+    bool bValid = bWritten && QString(Blob.Hash->result().toHex()) == Hash;
+    if (!bValid)
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Received Corrupted Blob " << Hash << "....Rejecting It!";
+#endif
+        Blob.File->cancelWriting();
+    }
+
+    bool bCommitted = bValid && Blob.File->commit();
+
+    delete Blob.File;
+    delete Blob.Hash;
+
+    return bCommitted;
+}
+
+void ContentStore::Discard(QString JobId)
+{
+    for (QString Key : PendingBlobs.keys())
+    {
+        if (Key.startsWith(JobId + "/"))
+        {
+            PendingBlob Blob = PendingBlobs.take(Key);
+            delete Blob.File;
+            delete Blob.Hash;
+        }
+    }
+}
+
+bool ContentStore::Checkout(QVariantList Manifest, QString RootPath)
+{
+    for (QVariant EntryVal : Manifest)
+    {
+        QVariantMap Entry = EntryVal.toMap();
+        QString RelativePath = Entry["path"].toString();
+
+        QString Hash = Entry["hash"].toString();
+
+        // Never let a manifest read or write outside of the store/root.
+        if (!IsSafeRelativePath(RelativePath) || !IsValidHash(Hash))
+        {
+            return false;
+        }
+
+        QString TargetPath = RootPath + "/" + RelativePath;
+        QDir().mkpath(QFileInfo(TargetPath).absolutePath());
+
+        // QFile::copy won't overwrite, so get rid of any previous version first.
+        QFile::remove(TargetPath);
+        if (!QFile::copy(GetBlobPath(Hash), TargetPath))
+        {
+#ifdef QT_DEBUG
+            qDebug() << "Unable To Check Out " << RelativePath << " To " << TargetPath;
+#endif
+            return false;
+        }
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 10, 0)
+        // Mark the blob as used, so Trim gets rid of the ones that haven't been used in the longest time first.
+        QFile Blob(GetBlobPath(Hash));
+        if (Blob.open(QFile::WriteOnly | QFile::Append))
+        {
+            Blob.setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+        }
+#endif
+    }
+
+    return true;
+}
+
+void ContentStore::Remove(QStringList Hashes)
+{
+    for (QString Hash : Hashes)
+    {
+        if (IsValidHash(Hash))
+        {
+            QFile::remove(GetBlobPath(Hash));
+        }
+    }
+}
+
+void ContentStore::Trim(qint64 MaxBytes)
+{
+    QList<QFileInfo> Blobs;
+    qint64 TotalSize = 0;
+
+    QDirIterator It(StorePath, QDir::Files, QDirIterator::Subdirectories);
+    while (It.hasNext())
+    {
+        It.next();
+
+        // Also picks up anything a crash left half received.
+        Blobs.append(It.fileInfo());
+        TotalSize += It.fileInfo().size();
+    }
+
+    // Oldest (least recently used) first.
+    std::sort(Blobs.begin(), Blobs.end(), [](const QFileInfo &A, const QFileInfo &B) { return A.lastModified() < B.lastModified(); });
+
+    for (int i = 0; i < Blobs.size() && TotalSize > MaxBytes; i++)
+    {
+        if (QFile::remove(Blobs[i].absoluteFilePath()))
+        {
+            TotalSize -= Blobs[i].size();
+        }
+    }
+}
+
+QString ContentStore::GetBlobPath(QString Hash)
+{
+    // Fan the blobs out over subdirectories so no single directory gets huge.
+    return StorePath + "/" + Hash.left(2) + "/" + Hash;
+}
+
+bool ContentStore::IsValidHash(QString Hash)
+{
+    // Hashes end up in file paths, so they had better be exactly what we'd generate ourselves.
+    static const QRegularExpression HashExpression("^[0-9a-f]{64}$");
+    return HashExpression.match(Hash).hasMatch();
+}
@@ -0,0 +1,67 @@
+#ifndef CONTENTSTORE_H
+#define CONTENTSTORE_H
+
+#include <QObject>
+#include <QMap>
+#include <QVariantList>
+#include <QVariantMap>
+#include <QSaveFile>
+#include <QCryptographicHash>
+
+// A directory of files keyed by the hash of their contents, used to avoid sending the same file over the network twice.
+/// NOTE: A manifest is a list of {"path": <relative path>, "hash": <content hash>} maps describing a directory tree.
+class ContentStore
+{
+public:
+    ContentStore(QString Path);
+    ~ContentStore();
+
+    // Hash every file under the root (skipping the excluded directory names) into a manifest, and remember where each hash came from in PathsByHash.
+    static QVariantList CreateManifest(QString RootPath, QStringList ExcludedDirs, QMap<QString, QString> &PathsByHash);
+
+    // Whether a path from a manifest (or the network) stays inside of whatever directory it's relative to.
+    static bool IsSafeRelativePath(QString RelativePath);
+
+    bool Contains(QString Hash);
+
+    // Get the (deduplicated) hashes in the manifest that aren't in the store yet.
+    QStringList Missing(QVariantList Manifest);
+
+    // Decompress & append a chunk of a blob being received for a job. The blob is verified & added to the store once its final chunk arrives.
+    /// NOTE: Returns false if the blob couldn't be written or didn't match its hash.
+    bool ReceiveChunk(QString JobId, QString Hash, QByteArray CompressedData, bool bFinal);
+
+    // Throw away any half received blobs for the job (eg. when its connection dropped).
+    void Discard(QString JobId);
+
+    // Recreate the directory tree described by the manifest under the root.
+    bool Checkout(QVariantList Manifest, QString RootPath);
+
+    // Delete blobs that aren't needed anymore (eg. outputs that have been checked out to their target).
+    void Remove(QStringList Hashes);
+
+    // Delete the least recently used blobs until the store is no bigger than the given size.
+    /// NOTE: Only call this while no jobs are being received or checked out, as it doesn't know which blobs they're about to use.
+    void Trim(qint64 MaxBytes);
+
+private:
+    Q_DISABLE_COPY(ContentStore)
+
+    // A blob that's still being received.
+    struct PendingBlob
+    {
+        QSaveFile *File;
+        QCryptographicHash *Hash;
+    };
+
+    QString GetBlobPath(QString Hash);
+
+    static bool IsValidHash(QString Hash);
+
+    QString StorePath;
+
+    // Keyed by job & hash, so two jobs receiving the same blob at once don't write into each other's file.
+    QMap<QString, PendingBlob> PendingBlobs;
+};
+
+#endif // CONTENTSTORE_H
@@ -1,8 +1,68 @@
 #include "mainwindow.h"
+#include "buildworker.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThread>
+#include <QSettings>
+#include <QtDebug>
+
+// Run headless as a build worker for the coordinator given on the command line (eg. uPBT --worker buildbox:47100 --capacity 2).
+int RunWorker(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser Parser;
+    Parser.addHelpOption();
+    Parser.addOption(QCommandLineOption("worker", "Build plugins for the coordinator at <host>[:<port>].", "host"));
+    Parser.addOption(QCommandLineOption("capacity", "How many plugins to build at once.", "count", "1"));
+    Parser.addOption(QCommandLineOption("store-size", "How many MB of plugin sources to keep around for future builds.", "MB", "10240"));
+    Parser.addOption(QCommandLineOption("token", "The coordinator's CoordinatorToken (defaults to this machine's CoordinatorToken setting).", "token"));
+    Parser.process(a);
+
+    QString Token = Parser.value("token");
+    if (Token.isEmpty())
+    {
+        Token = QSettings("HowToCompute", "uPBT").value("CoordinatorToken").toString();
+    }
+
+    if (Token.isEmpty())
+    {
+        qDebug() << "No Coordinator Token Given - Pass --token Or Set CoordinatorToken In This Machine's uPBT Settings.";
+        return 1;
+    }
+
+    QString Coordinator = Parser.value("worker");
+    QString Host = Coordinator.section(':', 0, 0);
+    quint16 Port = BUILD_COORDINATOR_DEFAULT_PORT;
+
+    if (Coordinator.contains(':'))
+    {
+        Port = Coordinator.section(':', 1, 1).toUShort();
+    }
+
+    // UAT already uses all of the cores for a single build, so don't build more than one plugin at a time by default.
+    int Capacity = qBound(1, Parser.value("capacity").toInt(), QThread::idealThreadCount());
+
+    qint64 StoreLimit = qMax(0LL, Parser.value("store-size").toLongLong()) * 1024 * 1024;
+
+    BuildWorker Worker(UnrealInstall::GetEngineInstalls(), Capacity, Token, StoreLimit);
+    Worker.Connect(Host, Port);
+
+    return a.exec();
+}
 
 int main(int argc, char *argv[])
 {
+    // Check for worker mode before creating the application, as workers shouldn't need a display.
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]).startsWith("--worker"))
+        {
+            return RunWorker(argc, argv);
+        }
+    }
+
     QApplication a(argc, argv);
     MainWindow w;
     w.show();
@@ -9,6 +9,7 @@
 #include <QJsonObject>
 #include <QJsonArray>
 #include <QSettings>
+#include <QLocale>
 
 #include <QMimeData>
 
@@ -19,6 +20,7 @@
 #include <QFileDialog>
 
 #include "builderrordialog.h"
+#include "processtree.h"
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
@@ -28,7 +30,7 @@ MainWindow::MainWindow(QWidget *parent) :
 
     setAcceptDrops(true);
 
-    UnrealInstallations = GetEngineInstalls();
+    UnrealInstallations = UnrealInstall::GetEngineInstalls();
 
     int i = 0;
     for (UnrealInstall EngineInstall : UnrealInstallations)
@@ -52,126 +54,145 @@ MainWindow::MainWindow(QWidget *parent) :
         /// NOTE: Format: "/BuiltPlugins/<pluginName>/<pluginVersion>/<engine_version>"
         BuildTargetFormat = QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/BuiltPlugins/%n/%v/%e";
     }
-}
-
-QList<UnrealInstall> MainWindow::GetEngineInstalls()
-{
-    // Get the ue4 versions
-    QList<UnrealInstall> UnrealInstalls;
 
-    // Fetch the binary install locations (for windows).
+    // Start keeping track of (and cleaning up) the output tree.
+    Retention = new RetentionManager(BuildTargetFormat, this);
+    connect(Retention, &RetentionManager::SpaceRequestFinished, this, &MainWindow::on_FreeSpace_requestFinished);
+    connect(Retention, &RetentionManager::ImportScanFinished, this, &MainWindow::on_ImportScan_finished);
+    Retention->RequestCleanup();
 
-#ifdef Q_OS_WIN
+    // Start accepting build workers if this machine has been set up as a coordinator.
+    Coordinator = new BuildCoordinator(this);
+    connect(Coordinator, &BuildCoordinator::WorkerAvailable, this, &MainWindow::StartNextBuild);
+    connect(Coordinator, &BuildCoordinator::JobFinished, this, &MainWindow::on_RemoteBuild_complete);
+    connect(Coordinator, &BuildCoordinator::JobLost, this, &MainWindow::on_RemoteBuild_lost);
 
-    QStringList paths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
-    QString ProgramDataPath;
+    if (Settings.contains("CoordinatorPort"))
+    {
+        Coordinator->Listen(Settings.value("CoordinatorPort", BUILD_COORDINATOR_DEFAULT_PORT).toUInt(), Settings.value("CoordinatorToken").toString());
+    }
 
-    for (QString path : paths)
+    // Pick up any builds the previous session didn't get to finish (eg. because it crashed or the machine rebooted).
+    QList<BuildJob> UnfinishedBuilds = Journal.Recover();
+    if (!UnfinishedBuilds.isEmpty())
     {
-        // Assuming that the *real* one is the only one ending in ProgramData
-        if (path.endsWith("ProgramData"))
+        QMessageBox::StandardButton Resume = QMessageBox::question(this, "Resume Builds?", QString("uPBT was closed while %1 build(s) were still queued or running. Would you like to resume them?").arg(UnfinishedBuilds.size()));
+
+        for (BuildJob Job : UnfinishedBuilds)
         {
-            ProgramDataPath = path;
-            break;
+            if (Resume == QMessageBox::Yes)
+            {
+                // These are already in the journal, so add them straight to the queue instead of resubmitting them.
+                PendingBuilds.append(Job);
+            }
+            else
+            {
+                Journal.MarkCancelled(Job.Id);
+            }
         }
 
-#ifdef QT_DEBUG
-    qDebug() << "Found GenericDataLocation Path: " << path;
-#endif
-
+        StartNextBuild();
     }
-    QString LauncherInstalledPath = ProgramDataPath + "/Epic/UnrealEngineLauncher/LauncherInstalled.dat";
+}
 
-    QFile LauncherInstalled(LauncherInstalledPath);
+void MainWindow::QueueBuild(QString PluginPath, UnrealInstall EngineInstall)
+{
+    BuildJob Job;
+    Job.PluginPath = PluginPath;
+    Job.EngineName = EngineInstall.GetName();
+    Job.EnginePath = EngineInstall.GetPath();
 
-    if (!LauncherInstalled.open(QFile::ReadOnly | QFile::Text))
+    // Journal it before anything else so it won't get lost if we go down before it's built.
+    if (!Journal.Submit(Job))
     {
 #ifdef QT_DEBUG
-        qDebug() << "Unable To Open LauncherInstalled.dat Engine Configuration File....Skipping Automatic Engine Detection. Path: " << LauncherInstalledPath;
+        qDebug() << "Unable To Journal Build Of " << PluginPath << " - It Won't Be Resumed If uPBT Crashes!";
 #endif
-
-        return UnrealInstalls;
-
     }
-    QTextStream LauncherInstalledTS(&LauncherInstalled);
-    QString LauncherInstalledText = LauncherInstalledTS.readAll();
 
-    QJsonObject jLauncherInstalled = QJsonDocument::fromJson(LauncherInstalledText.toUtf8()).object();
+    PendingBuilds.append(Job);
 
-    if (!jLauncherInstalled.contains("InstallationList") && jLauncherInstalled["InstallationList"].isArray())
-    {
-#ifdef QT_DEBUG
-         qDebug() << "Invalid LauncherInstalled.dat Engine Configuration File....Skipping Automatic Engine Detection";
-#endif
+    StartNextBuild();
+}
 
-         return UnrealInstalls;
+void MainWindow::StartNextBuild()
+{
+    if (bWaitingForSpace)
+    {
+        // The queue carries on once the retention manager has made room (see on_FreeSpace_requestFinished).
+        return;
     }
 
-    for (QJsonValue EngineInstallVal : jLauncherInstalled["InstallationList"].toArray())
+    // Hand off as many jobs as the connected workers can take first.
+    for (int i = 0; i < PendingBuilds.size();)
     {
-        if (!EngineInstallVal.isObject())
+        if (!Coordinator->CanDispatch(PendingBuilds[i]))
         {
-#ifdef QT_DEBUG
-         qDebug() << "Invalid Launcher Install....skipping this one!";
-         continue;
-#endif
+            // No (free) worker has this engine, so leave it for the local build.
+            i++;
+            continue;
         }
 
-        QJsonObject EngineInstall = EngineInstallVal.toObject();
-
-        QString EngineLocation = EngineInstall["InstallLocation"].toString();
-        QString EngineName = EngineInstall["AppName"].toString();
-
-        // Only get the ue4 builds - filter out the plugins  (that'll be formatted like ConfigBPPlugin_4.17
-        if (EngineName.startsWith("UE_"))
+        BuildJob Job = PendingBuilds[i];
+        bool bResolved = ResolveBuildTarget(Job);
+        if (bResolved && Retention->IsPinned(Job.Target))
         {
-            // Add this engine version to the unreal engine installs list
-            UnrealInstalls.append(UnrealInstall(EngineName, EngineLocation));
-
-#ifdef QT_DEBUG
-            qDebug() << "Found Engine Version: {Name=" << EngineName << ";Location=" << EngineLocation << "}";
-#endif
+            // Another build is still writing to the same output, so this one has to wait for it to finish.
+            i++;
+            continue;
         }
 
+        PendingBuilds.removeAt(i);
+        if (!bResolved)
+        {
+            Journal.MarkFinished(Job.Id, false);
+        }
+        else if (!Retention->HasFreeSpace(Job.Target))
+        {
+            // The outputs get copied back to this machine, so it needs the space just as much as for a local build.
+            WaitForFreeSpace(Job);
+            if (bWaitingForSpace)
+            {
+                return;
+            }
+        }
+        else if (Coordinator->Dispatch(Job))
+        {
+            // Pin before tracking, so the output can't be evicted the moment it becomes a candidate.
+            Retention->Pin(Job.Target);
+            Retention->Track(Job.Target, Job.PluginName, Job.PluginVersion, Job.EngineName);
+            Journal.MarkStarted(Job);
+        }
+        else
+        {
+            Journal.MarkFinished(Job.Id, false);
+        }
     }
 
-#endif
-
-    // Fetch any custom ue4 install paths the user may have added
-
-    // Open up uPBT's settings file
-    QSettings Settings("HowToCompute", "uPBT");
-
-    // Create a quick list to add the custom installs to (so they can be added seperate of the *proper* list in case anything goes wrong)
-    QList<UnrealInstall> CustomInstalls;
-
-    // Read the Custom Unreal Engine Installs array from the settings object.
-    int size = Settings.beginReadArray("CustomUnrealEngineInstalls");
-    for (int i = 0; i < size; ++i) {
-        // Get this element out of the settings
-        Settings.setArrayIndex(i);
-
-        // Extract the installation's name & path
-        QString InstallName = Settings.value("Name").toString();
-        QString InstallPath = Settings.value("Path").toString();
-
-        // Create an UnrealInstall based on the name & path, and add it to the Custom Installs list.
-        CustomInstalls.append(UnrealInstall(InstallName, InstallPath));
+    if (bIsBuilding)
+    {
+        // The completion handler will call us again.
+        return;
     }
 
-    // Done reading, so "close" the array.
-    Settings.endArray();
-
-    // Add the list of custom installs to the list of (binary) Unreal Engine installations.
-    UnrealInstalls += CustomInstalls;
+    // Build the first job whose output isn't being built to by a worker (the completion handlers call us again once it's free).
+    for (int i = 0; i < PendingBuilds.size(); i++)
+    {
+        BuildJob Job = PendingBuilds[i];
+        if (ResolveBuildTarget(Job) && Retention->IsPinned(Job.Target))
+        {
+            continue;
+        }
 
-    // Return the final list of UE4 binary installs & custom installs.
-    return UnrealInstalls;
+        bIsBuilding = true;
+        BuildPlugin(PendingBuilds.takeAt(i));
+        return;
+    }
 }
 
-void MainWindow::BuildPlugin(QString PluginPath)
+bool MainWindow::ResolveBuildTarget(BuildJob &Job)
 {
-    QFile PluginMeta(PluginPath);
+    QFile PluginMeta(Job.PluginPath);
 
     // Open the plugin to extract it's (friendly) name & version (name).
     /// NOTE: The above may be incorrect - however, this is how I believe most plugins do versioning & naming, and it is how I do it personally. Please open an issue if this causes huge issues for you!
@@ -180,10 +201,7 @@ void MainWindow::BuildPlugin(QString PluginPath)
 #ifdef QT_DEBUG
         qDebug() << "Error Opening UPlugin File to Generate Path & Build Plugin!";
 #endif
-        // Reset
-        bIsBuilding = false;
-        ui->progressBar->setValue(0);
-        return;
+        return false;
     }
 
     // Parse the uplugin file as a JSON document so we can easily extract the required information
@@ -196,30 +214,69 @@ void MainWindow::BuildPlugin(QString PluginPath)
     QString PluginVersion = jPlugin["VersionName"].toString();
 
     // Grab the engine's name for easy usage while formatting too
-    QString EngineVersion = SelectedUnrealInstallation.GetName();
+    QString EngineVersion = Job.EngineName;
 
     // Copy over the format string so we can format it based on the plugin/selected engine.
-    BuildTarget = BuildTargetFormat;
+    QString Target = BuildTargetFormat;
 
     // Replace the %n format specifier with the plugin's name if applicable
     if (BuildTargetFormat.contains("%n"))
     {
-        BuildTarget.replace("%n", PluginName);
+        Target.replace("%n", PluginName);
     }
 
     // Replace the %v format specifier with the plugin's version if applicable
     if (BuildTargetFormat.contains("%v"))
     {
-        BuildTarget.replace("%v", PluginVersion);
+        Target.replace("%v", PluginVersion);
     }
 
     // Replace the %e format specifier with the engine's name (usually version) if applicable
     if (BuildTargetFormat.contains("%e"))
     {
-        BuildTarget.replace("%e", EngineVersion);
+        Target.replace("%e", EngineVersion);
     }
 
-    QString RunUATPath = SelectedUnrealInstallation.GetPath() + "/Engine/Build/BatchFiles/RunUAT.bat";
+    Job.Target = Target;
+    Job.PluginName = PluginName;
+    Job.PluginVersion = PluginVersion;
+
+    return true;
+}
+
+void MainWindow::BuildPlugin(BuildJob Job)
+{
+    CurrentJob = Job;
+
+    QString PluginPath = Job.PluginPath;
+
+    if (!ResolveBuildTarget(CurrentJob))
+    {
+        // Reset & move on to the next plugin (this one will never build, so don't resume it either)
+        Journal.MarkFinished(Job.Id, false);
+        bIsBuilding = false;
+        ui->progressBar->setValue(0);
+        StartNextBuild();
+        return;
+    }
+
+    BuildTarget = CurrentJob.Target;
+
+    // Make sure UAT won't run out of disk space partway through the build.
+    if (!Retention->HasFreeSpace(BuildTarget))
+    {
+        bIsBuilding = false;
+        ui->progressBar->setValue(0);
+        WaitForFreeSpace(CurrentJob);
+        StartNextBuild();
+        return;
+    }
+
+    // Don't let the retention manager evict the output while we're building to it (but do let it clean it up later on).
+    Retention->Pin(BuildTarget);
+    Retention->Track(BuildTarget, CurrentJob.PluginName, CurrentJob.PluginVersion, CurrentJob.EngineName);
+
+    QString RunUATPath = UnrealInstall(Job.EngineName, Job.EnginePath).GetRunUATPath();
     QStringList RunUATFlags;
     RunUATFlags << "BuildPlugin";
     RunUATFlags << "-Plugin=" + PluginPath;
@@ -243,9 +300,33 @@ void MainWindow::BuildPlugin(QString PluginPath)
     // Run the UAT and wait until it's finished
     BuildProcess = new QProcess(this);
 
+    // UAT writes its errors to stderr, so merge it in to get them into the error dialog & the stored log.
+    BuildProcess->setProcessChannelMode(QProcess::MergedChannels);
+
     connect(BuildProcess, QOverload<int, QProcess::ExitStatus>::of(&QProcess::finished),this, &MainWindow::on_PluginBuild_complete);
     BuildProcess->start(RunUATPath, RunUATFlags);
 
+    if (!BuildProcess->waitForStarted())
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Start UAT @ " << RunUATPath;
+#endif
+        // The completion handler never gets called if UAT didn't start, so reset & move on to the next plugin here.
+        Journal.MarkFinished(Job.Id, false);
+        Retention->Unpin(BuildTarget);
+        BuildProcess->deleteLater();
+        bIsBuilding = false;
+        ui->progressBar->setValue(0);
+        StartNextBuild();
+        return;
+    }
+
+    // Record the target & PID so a future session can clean up after us if we don't make it to the completion handler.
+    CurrentJob.Target = BuildTarget;
+    CurrentJob.ProcessId = BuildProcess->processId();
+    CurrentJob.ProcessStartTime = ProcessTree::GetStartTime(CurrentJob.ProcessId);
+    Journal.MarkStarted(CurrentJob);
+
     // Set the progress bar to 50% to tell the user the build is in progress
     ui->progressBar->setValue(50);
 
@@ -259,51 +340,141 @@ bool MainWindow::on_PluginBuild_complete(int exitCode, QProcess::ExitStatus exit
 
     qDebug() << OutputLog;
 
+    // Journal the outcome straight away - whatever happens from here on, this job shouldn't be resumed.
+    Journal.MarkFinished(CurrentJob.Id, exitStatus == QProcess::NormalExit && exitCode == 0);
+
+    // Keep the log around so it can be searched when a similar failure shows up in the future.
+    LogIndex.AddLog(CurrentJob, exitStatus == QProcess::NormalExit && exitCode == 0, OutputLog);
+
+    // The output is now the most recently used one, and may have pushed the tree over its quota.
+    Retention->Unpin(BuildTarget);
+    Retention->Touch(BuildTarget);
+    Retention->RequestCleanup();
+
+    // Remember where this one went before the next build overwrites it.
+    QString FinishedTarget = BuildTarget;
+
+    // Reset everything & keep working through the queue before telling the user, so an unattended queue doesn't sit waiting for someone to click OK.
+    ui->progressBar->setValue(0);
+    BuildProcess->deleteLater();
+    bIsBuilding = false;
+
+    StartNextBuild();
+
     if (exitStatus == QProcess::NormalExit && exitCode == 0)
     {
 #ifdef QT_DEBUG
         qDebug() << "Successfully Built Plugin.";
 #endif
-        // We have successfully build the plugin!
-        ui->progressBar->setValue(100);
-
-        // Create a dialog telling the user the plugin was successfully compiles/built.
-        QMessageBox BuildSucceededDialog;
-        BuildSucceededDialog.setWindowTitle("Succeeded!");
-        BuildSucceededDialog.setTextFormat(Qt::RichText);
-        BuildSucceededDialog.setText(QString("We successfully built that plugin! Output: <a href=\"file://%1\">%1</a>").arg(BuildTarget));
-        BuildSucceededDialog.setStandardButtons(QMessageBox::Ok);
-        BuildSucceededDialog.exec();
+        // Create a dialog telling the user the plugin was successfully compiles/built (not modal, so it doesn't hold up the queue).
+        QMessageBox *BuildSucceededDialog = new QMessageBox(this);
+        BuildSucceededDialog->setAttribute(Qt::WA_DeleteOnClose);
+        BuildSucceededDialog->setWindowTitle("Succeeded!");
+        BuildSucceededDialog->setTextFormat(Qt::RichText);
+        BuildSucceededDialog->setText(QString("We successfully built that plugin! Output: <a href=\"file://%1\">%1</a>").arg(FinishedTarget));
+        BuildSucceededDialog->setStandardButtons(QMessageBox::Ok);
+        BuildSucceededDialog->show();
     }
     else
     {
 #ifdef QT_DEBUG
         qDebug() << "Finished Building Plugin Binaries, But Failed.";
 #endif
-        // This could be hit if the application is being shut down - so check if the UI window is still valid to avoid issues like segfaults.
-        if (ui)
-        {
-            // Changing the progress bar's state -> color is not the right thing to do with an error, so reset it to 0 and show an error dialog.
-            ui->progressBar->setValue(0);
+        // Create an error dialog that tells the user about the error that has happened (includes the output log).
+        BuildErrorDialog *dialog = new BuildErrorDialog(this, OutputLog);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    }
 
-            // Create an error dialog that tells the user about the error that has happened (includes the output log).
-            BuildErrorDialog dialog(this, OutputLog);
-            dialog.setModal(true);
-            dialog.exec();
-        }
-        else
-        {
-            // Be sure to just return as quickly as possible to avoid any potential issues - don't need to clean up as it's shutting down anyway and GC will do the job for us.
-            return false;
-        }
+    return true;
+}
+
+void MainWindow::WaitForFreeSpace(BuildJob Job)
+{
+    if (!Retention->CanFreeSpace())
+    {
+        // This job will never build, so don't resume it either.
+        Journal.MarkFinished(Job.Id, false);
+        ShowLowDiskSpaceError(Job);
+        return;
     }
 
-    // Reset everything!
-    ui->progressBar->setValue(0);
-    BuildProcess->deleteLater();
-    bIsBuilding = false;
+    // Evicting can take a while on big output trees, so do it in the background rather than freezing the UI.
+    bWaitingForSpace = true;
+    SpaceWaitingJob = Job;
+    Retention->RequestSpace(Job.Target);
 
-    return true;
+    ui->statusBar->showMessage("Cleaning up old builds to make room for the next one...");
+}
+
+void MainWindow::on_FreeSpace_requestFinished(QString TargetPath, bool bSucceeded)
+{
+    if (!bWaitingForSpace || TargetPath != SpaceWaitingJob.Target)
+    {
+        return;
+    }
+
+    bWaitingForSpace = false;
+    ui->statusBar->clearMessage();
+
+    if (bSucceeded)
+    {
+        // Put it back at the front of the queue so it's the next one to get built.
+        SpaceWaitingJob.Target.clear();
+        PendingBuilds.prepend(SpaceWaitingJob);
+    }
+    else
+    {
+        Journal.MarkFinished(SpaceWaitingJob.Id, false);
+        ShowLowDiskSpaceError(SpaceWaitingJob);
+    }
+
+    StartNextBuild();
+}
+
+void MainWindow::ShowLowDiskSpaceError(BuildJob Job)
+{
+    // Not modal, as this can happen while working through the queue (and a dialog shouldn't hold that up).
+    QMessageBox *ErrorPrompt = new QMessageBox(this);
+    ErrorPrompt->setAttribute(Qt::WA_DeleteOnClose);
+    ErrorPrompt->setWindowTitle("Uh Oh!");
+    ErrorPrompt->setText(QString("There isn't enough free disk space to build %1 to %2. Please free up some space (or set up a quota in uPBT's settings) and try again.").arg(QFileInfo(Job.PluginPath).baseName(), Job.Target));
+    ErrorPrompt->setStandardButtons(QMessageBox::Ok);
+    ErrorPrompt->show();
+}
+
+void MainWindow::on_RemoteBuild_complete(BuildJob Job, bool bSucceeded, QString OutputLog)
+{
+    Journal.MarkFinished(Job.Id, bSucceeded);
+    LogIndex.AddLog(Job, bSucceeded, OutputLog);
+
+    Retention->Unpin(Job.Target);
+    Retention->Touch(Job.Target);
+    Retention->RequestCleanup();
+
+    if (bSucceeded)
+    {
+        // Remote builds can finish at any time (and many at once), so don't interrupt the user with a dialog for each of them.
+        ui->statusBar->showMessage("A build worker successfully built a plugin.", 10000);
+    }
+    else
+    {
+        BuildErrorDialog *dialog = new BuildErrorDialog(this, OutputLog);
+        dialog->setAttribute(Qt::WA_DeleteOnClose);
+        dialog->show();
+    }
+
+    StartNextBuild();
+}
+
+void MainWindow::on_RemoteBuild_lost(BuildJob Job)
+{
+    // Put it back at the front of the queue so it's the next one to get built (either by another worker or locally).
+    Retention->Unpin(Job.Target);
+    Job.Target.clear();
+    PendingBuilds.prepend(Job);
+
+    StartNextBuild();
 }
 
 void MainWindow::dragEnterEvent(QDragEnterEvent *event)
@@ -329,17 +500,9 @@ void MainWindow::dropEvent(QDropEvent *event)
 {
     qDebug() << "Going to build plugin @ " << event->mimeData()->urls().at(0).toLocalFile() << "...";
 
-    if (bIsBuilding)
-    {
-        // There is still a build process going on - can't build! (don't show a popup as that'd only be annoying)
-    }
-    else
-    {
-        // Attempt to build the plugin!
-        event->acceptProposedAction();
-        bIsBuilding = true;
-        BuildPlugin(event->mimeData()->urls().at(0).toLocalFile());
-    }
+    // Queue the plugin up - it'll start building right away if nothing else is building at the moment.
+    event->acceptProposedAction();
+    QueueBuild(event->mimeData()->urls().at(0).toLocalFile(), SelectedUnrealInstallation);
 }
 
 void MainWindow::on_EngineVersionSelector_currentIndexChanged(int index)
@@ -537,7 +700,150 @@ void MainWindow::on_actionRemove_Unreal_Engine_Install_triggered()
     }
 }
 
+void MainWindow::on_actionSearch_Build_Logs_triggered()
+{
+    bool bGotQuery;
+    QString Query = QInputDialog::getText(this, "Search Build Logs", "Search All Previous Build Logs For (eg. C4668 Foo.h):", QLineEdit::Normal, "", &bGotQuery);
+
+    if (!bGotQuery || Query.trimmed().isEmpty())
+    {
+        // The user cancelled the dialog or didn't enter anything to search for.
+        return;
+    }
+
+    if (!LogIndex.IsLoaded())
+    {
+        QMessageBox LoadingPrompt;
+        LoadingPrompt.setWindowTitle("Still Loading");
+        LoadingPrompt.setText("The build logs are still being loaded in the background. Please try again in a moment.");
+        LoadingPrompt.setStandardButtons(QMessageBox::Ok);
+        LoadingPrompt.exec();
+        return;
+    }
+
+    QList<BuildLogHit> Hits = LogIndex.Search(Query);
+
+    if (Hits.isEmpty())
+    {
+        QMessageBox NoHitsPrompt;
+        NoHitsPrompt.setWindowTitle("No Results");
+        NoHitsPrompt.setText("None of the previous builds' logs contain all of those words on a single line.");
+        NoHitsPrompt.setStandardButtons(QMessageBox::Ok);
+        NoHitsPrompt.exec();
+        return;
+    }
+
+    // Let the user pick which of the matching lines they want to see.
+    QStringList Items;
+    for (BuildLogHit Hit : Hits)
+    {
+        Items << QString("%1 (%2) @ %3, Line %4: %5").arg(QFileInfo(Hit.PluginPath).baseName(), Hit.EngineName, QLocale().toString(Hit.Time, QLocale::ShortFormat), QString::number(Hit.Line + 1), Hit.Text.trimmed());
+    }
+
+    QInputDialog HitDialog;
+    HitDialog.setOptions(QInputDialog::UseListViewForComboBoxItems);
+    HitDialog.setComboBoxItems(Items);
+    HitDialog.setWindowTitle(QString("%1 Matching Line(s)").arg(Hits.size()));
+
+    if (!HitDialog.exec())
+    {
+        return;
+    }
+
+    int HitIndex = Items.indexOf(HitDialog.textValue());
+    if (HitIndex < 0)
+    {
+        return;
+    }
+
+    BuildLogHit Hit = Hits[HitIndex];
+
+    // Open the whole log at the line that matched.
+    BuildErrorDialog dialog(this, LogIndex.ReadLog(Hit.LogId));
+    dialog.setWindowTitle("Build Log");
+    dialog.SetHeading(QString("%1 (%2) - %3").arg(QFileInfo(Hit.PluginPath).baseName(), Hit.EngineName, Hit.bSucceeded ? "Succeeded" : "Failed"));
+    dialog.ShowLine(Hit.Line);
+    dialog.setModal(true);
+    dialog.exec();
+}
+
+void MainWindow::on_actionOutput_Disk_Usage_triggered()
+{
+    QList<OutputUsage> Outputs = Retention->GetUsage();
+
+    // Add up the sizes of all of the outputs per plugin & per engine.
+    QMap<QString, qint64> PluginUsage;
+    QMap<QString, qint64> EngineUsage;
+    qint64 TotalUsage = 0;
+
+    for (OutputUsage Output : Outputs)
+    {
+        PluginUsage[Output.PluginName.isEmpty() ? "(Unknown)" : Output.PluginName] += Output.Size;
+        EngineUsage[Output.EngineName.isEmpty() ? "(Unknown)" : Output.EngineName] += Output.Size;
+        TotalUsage += Output.Size;
+    }
+
+    QString Report = QString("<b>%1 Built Plugin(s), %2 MB In Total</b>").arg(Outputs.size()).arg(TotalUsage / (1024.0 * 1024.0), 0, 'f', 1);
+
+    Report += "<br><br><b>Per Plugin:</b>";
+    for (QString PluginName : PluginUsage.keys())
+    {
+        Report += QString("<br>%1: %2 MB").arg(PluginName.toHtmlEscaped()).arg(PluginUsage[PluginName] / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    Report += "<br><br><b>Per Engine:</b>";
+    for (QString EngineName : EngineUsage.keys())
+    {
+        Report += QString("<br>%1: %2 MB").arg(EngineName.toHtmlEscaped()).arg(EngineUsage[EngineName] / (1024.0 * 1024.0), 0, 'f', 1);
+    }
+
+    QMessageBox UsageDialog;
+    UsageDialog.setWindowTitle("Output Disk Usage");
+    UsageDialog.setTextFormat(Qt::RichText);
+    UsageDialog.setText(Report);
+    UsageDialog.setStandardButtons(QMessageBox::Ok);
+    UsageDialog.exec();
+
+    // Refresh the numbers for next time.
+    Retention->RequestCleanup();
+}
+
+void MainWindow::on_actionTrack_Existing_Builds_triggered()
+{
+    Retention->RequestImportScan();
+    ui->statusBar->showMessage("Looking for existing builds in the build target directory...", 5000);
+}
+
+void MainWindow::on_ImportScan_finished(int Count, qint64 Size)
+{
+    if (Count == 0)
+    {
+        QMessageBox::information(this, "Track Existing Builds", "No untracked builds were found in the build target directory.");
+        return;
+    }
+
+    QString Question = QString("Found %1 existing build(s) (%2 MB) that uPBT isn't tracking yet.\n\nTrack them? They will count towards the output quota, and may be deleted by uPBT to stay within it.").arg(Count).arg(Size / (1024.0 * 1024.0), 0, 'f', 1);
+    if (QMessageBox::question(this, "Track Existing Builds", Question, QMessageBox::Yes | QMessageBox::No) == QMessageBox::Yes)
+    {
+        Retention->ImportScanned();
+    }
+}
+
 MainWindow::~MainWindow()
 {
+    // The completion handlers use members that are about to be destroyed, so make sure none of them can fire from here on.
+    Coordinator->disconnect(this);
+    Retention->disconnect(this);
+
+    if (bIsBuilding)
+    {
+        BuildProcess->disconnect(this);
+
+        // Take UAT's whole tree down with us (QProcess would only kill the script), but leave the job as started so the next session resumes it.
+        ProcessTree::Kill(BuildProcess->processId());
+        BuildProcess->kill();
+        BuildProcess->waitForFinished();
+    }
+
     delete ui;
 }
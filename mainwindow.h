@@ -13,6 +13,10 @@
 #include <QProcess>
 
 #include "unrealinstall.h"
+#include "buildjournal.h"
+#include "buildcoordinator.h"
+#include "buildlogindex.h"
+#include "retentionmanager.h"
 
 namespace Ui {
 class MainWindow;
@@ -37,25 +41,75 @@ private slots:
 
     void on_actionRemove_Unreal_Engine_Install_triggered();
 
+    void on_actionSearch_Build_Logs_triggered();
+
+    void on_actionOutput_Disk_Usage_triggered();
+
+    void on_actionTrack_Existing_Builds_triggered();
+
 
 private:
     Ui::MainWindow *ui;
 
-    QList<UnrealInstall> GetEngineInstalls();
+    // Journal a new build of the plugin for the given engine and add it to the queue.
+    void QueueBuild(QString PluginPath, UnrealInstall EngineInstall);
+
+    // Start building the next queued job if nothing is building at the moment.
+    void StartNextBuild();
+
+    // Work out (using the build target format) where the job's plugin should be built to.
+    bool ResolveBuildTarget(BuildJob &Job);
+
+    void BuildPlugin(BuildJob Job);
+
+    // Have the retention manager make room for the job in the background (holding up the queue until it's done), or drop the job if it isn't allowed to.
+    void WaitForFreeSpace(BuildJob Job);
+
+    // Let the user know a job was dropped because there isn't enough space left for its output.
+    void ShowLowDiskSpaceError(BuildJob Job);
+
+    void on_FreeSpace_requestFinished(QString TargetPath, bool bSucceeded);
 
-    void BuildPlugin(QString PluginPath);
+    // Ask the user whether to start tracking the existing builds the retention manager found.
+    void on_ImportScan_finished(int Count, qint64 Size);
 
     bool on_PluginBuild_complete(int exitCode, QProcess::ExitStatus exitStatus);
 
+    void on_RemoteBuild_complete(BuildJob Job, bool bSucceeded, QString OutputLog);
+
+    void on_RemoteBuild_lost(BuildJob Job);
+
     UnrealInstall SelectedUnrealInstallation;
 
     QList<UnrealInstall> UnrealInstallations;
 
     // This hack sucks - but it's the only real way to get the output log of the build command to the completion/failure handler
-    QProcess *BuildProcess;
+    QProcess *BuildProcess = nullptr;
 
     bool bIsBuilding = false;
 
+    // Keeps track of every job's state on disk so the queue survives crashes/reboots.
+    BuildJournal Journal;
+
+    // The builds that are waiting for the current build to finish.
+    QList<BuildJob> PendingBuilds;
+
+    // The job that is currently being built (locally).
+    BuildJob CurrentJob;
+
+    // Nothing else gets started while the retention manager is making room for this job.
+    bool bWaitingForSpace = false;
+    BuildJob SpaceWaitingJob;
+
+    // Every build's output log, searchable.
+    BuildLogIndex LogIndex;
+
+    // Keeps the output tree within its quotas & makes sure there's room for new builds.
+    RetentionManager *Retention;
+
+    // Hands jobs to build workers on other machines (only listens for them if a CoordinatorPort has been configured).
+    BuildCoordinator *Coordinator;
+
     // The format string (either default or read from config) to use when deciding where to build a plugin to.
     QString BuildTargetFormat;
 
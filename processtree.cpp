@@ -0,0 +1,132 @@
+#include "processtree.h"
+#include <QtDebug>
+#include <QDir>
+#include <QFile>
+#include <QMap>
+#include <QProcess>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <signal.h>
+#endif
+
+#ifndef Q_OS_WIN
+// Read the fields of /proc/<pid>/stat that come after the process' name, so the first one is its state (field 3 in proc(5)).
+static QStringList ReadStatFields(qint64 ProcessId)
+{
+    QFile Stat(QString("/proc/%1/stat").arg(ProcessId));
+    if (!Stat.open(QFile::ReadOnly))
+    {
+        return QStringList();
+    }
+
+    // Format: "<pid> (<name>) <state> <ppid> ..." - the name can contain spaces & parentheses, so start after the last ')'.
+    QString StatLine = QString(Stat.readAll());
+    return StatLine.mid(StatLine.lastIndexOf(')') + 1).trimmed().split(' ');
+}
+#endif
+
+QString ProcessTree::GetStartTime(qint64 ProcessId)
+{
+#ifdef Q_OS_WIN
+    HANDLE Process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, static_cast<DWORD>(ProcessId));
+    if (!Process)
+    {
+        return QString();
+    }
+
+    FILETIME CreationTime, ExitTime, KernelTime, UserTime;
+    DWORD ExitCode = 0;
+    bool bRunning = GetProcessTimes(Process, &CreationTime, &ExitTime, &KernelTime, &UserTime) && GetExitCodeProcess(Process, &ExitCode) && ExitCode == STILL_ACTIVE;
+    CloseHandle(Process);
+
+    if (!bRunning)
+    {
+        return QString();
+    }
+
+    return QString::number((quint64(CreationTime.dwHighDateTime) << 32) | CreationTime.dwLowDateTime);
+#else
+    // The start time (field 22) is in clock ticks since boot, so it only means something together with the boot it's from.
+    QStringList Fields = ReadStatFields(ProcessId);
+    if (Fields.size() < 20)
+    {
+        return QString();
+    }
+
+    QFile BootId("/proc/sys/kernel/random/boot_id");
+    if (!BootId.open(QFile::ReadOnly))
+    {
+        return QString();
+    }
+
+    return QString(BootId.readAll()).trimmed() + ":" + Fields[19];
+#endif
+}
+
+QString ProcessTree::ReadCommandLine(qint64 ProcessId)
+{
+#ifdef Q_OS_WIN
+    // Windows only exposes other processes' command lines through WMI.
+    QProcess PowerShell;
+    PowerShell.start("powershell", QStringList() << "-NoProfile" << "-NonInteractive" << "-Command" << QString("(Get-CimInstance Win32_Process -Filter 'ProcessId=%1').CommandLine").arg(ProcessId));
+    PowerShell.waitForFinished();
+
+    return QString(PowerShell.readAllStandardOutput()).trimmed();
+#else
+    QFile CommandLine(QString("/proc/%1/cmdline").arg(ProcessId));
+    if (!CommandLine.open(QFile::ReadOnly))
+    {
+        return QString();
+    }
+
+    // The arguments are seperated by null characters.
+    return QString(CommandLine.readAll().replace('\0', ' ')).trimmed();
+#endif
+}
+
+bool ProcessTree::Kill(qint64 ProcessId)
+{
+#ifdef Q_OS_WIN
+    // /T takes down the whole tree (UBT, the compilers, etc) with it.
+    QProcess TaskKill;
+    TaskKill.start("taskkill", QStringList() << "/F" << "/T" << "/PID" << QString::number(ProcessId));
+    TaskKill.waitForFinished();
+
+    return TaskKill.exitStatus() == QProcess::NormalExit && TaskKill.exitCode() == 0;
+#else
+    // Find everything the process started (UBT, mono/dotnet, the compilers, etc) by walking /proc.
+    QMap<qint64, QList<qint64>> ChildrenByParent;
+    for (QString Entry : QDir("/proc").entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        bool bIsProcess;
+        qint64 Pid = Entry.toLongLong(&bIsProcess);
+        if (!bIsProcess)
+        {
+            continue;
+        }
+
+        QStringList Fields = ReadStatFields(Pid);
+        if (Fields.size() > 1)
+        {
+            ChildrenByParent[Fields[1].toLongLong()].append(Pid);
+        }
+    }
+
+    QList<qint64> Processes;
+    Processes.append(ProcessId);
+    for (int i = 0; i < Processes.size(); i++)
+    {
+        Processes += ChildrenByParent.value(Processes[i]);
+    }
+
+    // Stop the children before their parents, so nothing gets the chance to start anything new.
+    for (int i = Processes.size() - 1; i > 0; i--)
+    {
+        kill(static_cast<pid_t>(Processes[i]), SIGTERM);
+    }
+
+    return kill(static_cast<pid_t>(ProcessId), SIGTERM) == 0;
+#endif
+}
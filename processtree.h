@@ -0,0 +1,21 @@
+#ifndef PROCESSTREE_H
+#define PROCESSTREE_H
+
+#include <QObject>
+
+// Helpers for dealing with UAT's process tree, as UAT itself is just a script that starts UBT, the compilers, etc.
+class ProcessTree
+{
+public:
+    // Identifies when the process was started (or an empty string if it isn't running).
+    /// NOTE: PIDs get reused (freely so after a reboot), so compare this to the one recorded when the process was started before trusting a PID.
+    static QString GetStartTime(qint64 ProcessId);
+
+    // The process' full command line (or an empty string if it isn't running or can't be read).
+    static QString ReadCommandLine(qint64 ProcessId);
+
+    // Kill the process & everything it started, as they'd otherwise keep on running without it.
+    static bool Kill(qint64 ProcessId);
+};
+
+#endif // PROCESSTREE_H
@@ -0,0 +1,670 @@
+#include "retentionmanager.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSettings>
+#include <QStorageInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QMap>
+
+#include <algorithm>
+
+// The later of two times, where an invalid time counts as never.
+static QDateTime Latest(QDateTime A, QDateTime B)
+{
+    if (!A.isValid())
+    {
+        return B;
+    }
+
+    if (!B.isValid())
+    {
+        return A;
+    }
+
+    return qMax(A, B);
+}
+
+RetentionManager::RetentionManager(QString TargetFormat, QObject *parent) :
+    QThread(parent)
+{
+    QString Format = QDir::fromNativeSeparators(TargetFormat);
+
+    // Everything before the directory containing the first format specifier is shared by all outputs (eg. ".../BuiltPlugins").
+    int FirstSpecifier = Format.indexOf('%');
+    int RootEnd = Format.left(FirstSpecifier < 0 ? Format.length() : FirstSpecifier).lastIndexOf('/');
+
+    if (FirstSpecifier >= 0 && RootEnd > 0)
+    {
+        OutputRoot = NormalizePath(Format.left(RootEnd));
+
+        // Turn each directory level below the root into an expression, so existing outputs (& which plugin/version/engine they belong to) can be recognized when importing them.
+        for (QString Component : Format.mid(RootEnd + 1).split('/'))
+        {
+            if (Component.isEmpty())
+            {
+                continue;
+            }
+
+            FormatComponent Matcher;
+            QString Pattern = "^";
+
+            for (int i = 0; i < Component.length(); i++)
+            {
+                if (Component.at(i) == '%' && i + 1 < Component.length() && QString("nve").contains(Component.at(i + 1)))
+                {
+                    Pattern += "(.+)";
+                    Matcher.Specifiers += Component.at(i + 1);
+                    i++;
+                }
+                else
+                {
+                    Pattern += QRegularExpression::escape(QString(Component.at(i)));
+                }
+            }
+
+            Matcher.Expression = QRegularExpression(Pattern + "$");
+            Components.append(Matcher);
+        }
+    }
+
+    // Read back which outputs we've built & when each was last used (file access times are unreliable, and disabled on most Windows installs).
+    ManifestPath = QStandardPaths::standardLocations(QStandardPaths::DataLocation)[0] + "/OutputManifest.json";
+
+    QFile ManifestFile(ManifestPath);
+    if (ManifestFile.open(QFile::ReadOnly | QFile::Text))
+    {
+        QJsonObject jManifest = QJsonDocument::fromJson(ManifestFile.readAll()).object();
+        QJsonObject jOutputs = jManifest["outputs"].toObject();
+        for (QString Path : jOutputs.keys())
+        {
+            QJsonObject jOutput = jOutputs[Path].toObject();
+
+            OutputUsage Output;
+            Output.Path = Path;
+            Output.PluginName = jOutput["plugin"].toString();
+            Output.PluginVersion = jOutput["version"].toString();
+            Output.EngineName = jOutput["engine"].toString();
+            Output.LastAccess = QDateTime::fromString(jOutput["lastAccess"].toString(), Qt::ISODate);
+
+            Tracked.insert(Path, Output);
+        }
+
+        for (QJsonValue jPath : jManifest["evicting"].toArray())
+        {
+            PendingRemovals.insert(jPath.toString());
+        }
+    }
+
+    LoadSettings();
+}
+
+RetentionManager::~RetentionManager()
+{
+    // Don't leave a half finished scan running while we're being destroyed.
+    requestInterruption();
+    wait();
+}
+
+void RetentionManager::RequestCleanup()
+{
+    LoadSettings();
+
+    QMutexLocker Lock(&Mutex);
+    bRerun = true;
+    Lock.unlock();
+
+    StartIfIdle();
+}
+
+bool RetentionManager::HasFreeSpace(QString TargetPath)
+{
+    QMutexLocker Lock(&Mutex);
+    qint64 RequiredBytes = MinFreeBytes;
+    Lock.unlock();
+
+    QStorageInfo Storage(GetExistingPath(TargetPath));
+    return !Storage.isValid() || Storage.bytesAvailable() >= RequiredBytes;
+}
+
+bool RetentionManager::CanFreeSpace()
+{
+    QMutexLocker Lock(&Mutex);
+    return bEvictWhenLowOnSpace;
+}
+
+void RetentionManager::RequestSpace(QString TargetPath)
+{
+    QMutexLocker Lock(&Mutex);
+    SpaceRequests.append(TargetPath);
+    Lock.unlock();
+
+    StartIfIdle();
+}
+
+void RetentionManager::Track(QString OutputPath, QString PluginName, QString PluginVersion, QString EngineName)
+{
+    QMutexLocker Lock(&Mutex);
+    OutputUsage &Output = Tracked[NormalizePath(OutputPath)];
+    Output.Path = NormalizePath(OutputPath);
+    Output.PluginName = PluginName;
+    Output.PluginVersion = PluginVersion;
+    Output.EngineName = EngineName;
+    Output.LastAccess = QDateTime::currentDateTime();
+    Lock.unlock();
+
+    SaveManifest();
+}
+
+void RetentionManager::Touch(QString OutputPath)
+{
+    QMutexLocker Lock(&Mutex);
+    QHash<QString, OutputUsage>::iterator Output = Tracked.find(NormalizePath(OutputPath));
+    if (Output == Tracked.end())
+    {
+        // Not something we built (or it has been evicted since).
+        return;
+    }
+
+    Output->LastAccess = QDateTime::currentDateTime();
+    Lock.unlock();
+
+    SaveManifest();
+}
+
+void RetentionManager::Pin(QString OutputPath)
+{
+    QMutexLocker Lock(&Mutex);
+    PinCounts[NormalizePath(OutputPath)]++;
+}
+
+void RetentionManager::Unpin(QString OutputPath)
+{
+    QMutexLocker Lock(&Mutex);
+    QHash<QString, int>::iterator PinCount = PinCounts.find(NormalizePath(OutputPath));
+    if (PinCount != PinCounts.end() && --PinCount.value() <= 0)
+    {
+        PinCounts.erase(PinCount);
+    }
+}
+
+bool RetentionManager::IsPinned(QString OutputPath)
+{
+    QMutexLocker Lock(&Mutex);
+    return PinCounts.contains(NormalizePath(OutputPath));
+}
+
+void RetentionManager::RequestImportScan()
+{
+    QMutexLocker Lock(&Mutex);
+    bImportScanRequested = true;
+    Lock.unlock();
+
+    StartIfIdle();
+}
+
+void RetentionManager::ImportScanned()
+{
+    QMutexLocker Lock(&Mutex);
+    for (OutputUsage Output : ImportCandidates)
+    {
+        if (!Tracked.contains(Output.Path))
+        {
+            // Keep the time it was last modified, so imported outputs don't all look like they were just used.
+            Tracked.insert(Output.Path, Output);
+        }
+    }
+    ImportCandidates.clear();
+
+    WriteManifest();
+    Lock.unlock();
+
+    RequestCleanup();
+}
+
+QList<OutputUsage> RetentionManager::GetUsage()
+{
+    QMutexLocker Lock(&Mutex);
+    return Usage;
+}
+
+void RetentionManager::run()
+{
+    forever
+    {
+        QMutexLocker Lock(&Mutex);
+        if ((!bRerun && SpaceRequests.isEmpty() && !bImportScanRequested) || isInterruptionRequested())
+        {
+            bActive = false;
+            return;
+        }
+        bRerun = false;
+
+        QStringList Requests = SpaceRequests;
+        SpaceRequests.clear();
+
+        bool bImportScan = bImportScanRequested;
+        bImportScanRequested = false;
+        Lock.unlock();
+
+        RemoveEvictedOutputs();
+
+        // Making room evicts in the same (least recently used) order as any other cleanup.
+        Cleanup();
+
+        for (QString TargetPath : Requests)
+        {
+            emit SpaceRequestFinished(TargetPath, HasFreeSpace(TargetPath));
+        }
+
+        if (bImportScan)
+        {
+            QList<OutputUsage> Candidates;
+            if (!OutputRoot.isEmpty() && !Components.isEmpty())
+            {
+                FindUntrackedOutputs(OutputRoot, 0, OutputUsage(), Candidates);
+            }
+
+            qint64 TotalSize = 0;
+            for (OutputUsage Candidate : Candidates)
+            {
+                TotalSize += Candidate.Size;
+            }
+
+            Lock.relock();
+            ImportCandidates = Candidates;
+            Lock.unlock();
+
+            emit ImportScanFinished(Candidates.size(), TotalSize);
+        }
+    }
+}
+
+void RetentionManager::StartIfIdle()
+{
+    QMutexLocker Lock(&Mutex);
+    if (bActive)
+    {
+        // The running cleanup will pick the request up once it's done.
+        return;
+    }
+
+    bActive = true;
+    Lock.unlock();
+
+    // The previous run may still be on its way out.
+    wait();
+    start(QThread::LowPriority);
+}
+
+void RetentionManager::LoadSettings()
+{
+    QSettings Settings("HowToCompute", "uPBT");
+
+    QMutexLocker Lock(&Mutex);
+    QuotaBytes = Settings.value("RetentionQuotaMB", 0).toLongLong() * 1024 * 1024;
+    KeepVersions = Settings.value("RetentionKeepVersions", 0).toInt();
+    MinFreeBytes = Settings.value("RetentionMinFreeMB", 2048).toLongLong() * 1024 * 1024;
+    bEvictWhenLowOnSpace = Settings.value("RetentionEvictWhenLowOnSpace", false).toBool();
+}
+
+void RetentionManager::Cleanup()
+{
+    QMutexLocker Lock(&Mutex);
+    QList<OutputUsage> TrackedOutputs = Tracked.values();
+    qint64 Quota = QuotaBytes;
+    int Versions = KeepVersions;
+    qint64 MinFree = MinFreeBytes;
+    bool bMayEvict = bEvictWhenLowOnSpace;
+    Lock.unlock();
+
+    // Work out how big each output is & when it was last touched.
+    QList<OutputUsage> Outputs;
+    QStringList Vanished;
+    for (OutputUsage Output : TrackedOutputs)
+    {
+        if (isInterruptionRequested())
+        {
+            return;
+        }
+
+        if (!QFileInfo(Output.Path).isDir())
+        {
+            Vanished.append(Output.Path);
+            continue;
+        }
+
+        QDateTime LastModified;
+        QDirIterator It(Output.Path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (It.hasNext())
+        {
+            It.next();
+            Output.Size += It.fileInfo().size();
+            LastModified = Latest(LastModified, It.fileInfo().lastModified());
+        }
+
+        Output.LastAccess = Latest(LastModified, Output.LastAccess);
+        Outputs.append(Output);
+    }
+
+    // Stop tracking outputs that have been deleted by something else (eg. the user).
+    if (!Vanished.isEmpty())
+    {
+        Lock.relock();
+        for (QString Path : Vanished)
+        {
+            // Pinned outputs are just still being built.
+            if (!PinCounts.contains(Path))
+            {
+                Tracked.remove(Path);
+            }
+        }
+        Lock.unlock();
+
+        SaveManifest();
+    }
+
+    // Least recently used first, so that's what gets evicted first.
+    std::sort(Outputs.begin(), Outputs.end(), [](const OutputUsage &A, const OutputUsage &B) { return A.LastAccess < B.LastAccess; });
+
+    QList<OutputUsage> Remaining;
+
+    // Only keep the most recently used versions of each plugin (in all of the engines they were built for).
+    if (Versions > 0)
+    {
+        QMap<QString, QMap<QString, QDateTime>> VersionAccess;
+        for (OutputUsage Output : Outputs)
+        {
+            QDateTime &LastAccess = VersionAccess[Output.PluginName][Output.PluginVersion];
+            LastAccess = Latest(LastAccess, Output.LastAccess);
+        }
+
+        QSet<QString> ExpiredVersions;
+        for (QString PluginName : VersionAccess.keys())
+        {
+            QList<QPair<QDateTime, QString>> PluginVersions;
+            for (QString PluginVersion : VersionAccess[PluginName].keys())
+            {
+                PluginVersions.append(qMakePair(VersionAccess[PluginName][PluginVersion], PluginVersion));
+            }
+
+            std::sort(PluginVersions.begin(), PluginVersions.end(), [](const QPair<QDateTime, QString> &A, const QPair<QDateTime, QString> &B) { return A.first > B.first; });
+
+            for (int i = Versions; i < PluginVersions.size(); i++)
+            {
+                ExpiredVersions.insert(PluginName + "/" + PluginVersions[i].second);
+            }
+        }
+
+        for (OutputUsage Output : Outputs)
+        {
+            if (!ExpiredVersions.contains(Output.PluginName + "/" + Output.PluginVersion) || !Evict(Output))
+            {
+                Remaining.append(Output);
+            }
+        }
+    }
+    else
+    {
+        Remaining = Outputs;
+    }
+
+    qint64 TotalSize = 0;
+    for (OutputUsage Output : Remaining)
+    {
+        TotalSize += Output.Size;
+    }
+
+    // Free space is per drive, as the outputs may be spread over several of them (eg. if the build target format was changed).
+    QHash<QString, qint64> FreeBytes;
+
+    // Evict the least recently used outputs until we're within the quota & (if allowed to) have enough free space for the next build.
+    QList<OutputUsage> Kept;
+    for (OutputUsage Output : Remaining)
+    {
+        QStorageInfo Storage(Output.Path);
+        if (!FreeBytes.contains(Storage.rootPath()))
+        {
+            FreeBytes.insert(Storage.rootPath(), Storage.isValid() ? Storage.bytesAvailable() : MinFree);
+        }
+
+        bool bOverQuota = Quota > 0 && TotalSize > Quota;
+        bool bLowOnSpace = bMayEvict && FreeBytes[Storage.rootPath()] < MinFree;
+
+        if ((bOverQuota || bLowOnSpace) && Evict(Output))
+        {
+            TotalSize -= Output.Size;
+            FreeBytes[Storage.rootPath()] += Output.Size;
+            continue;
+        }
+
+        Kept.append(Output);
+    }
+
+    Lock.relock();
+    Usage = Kept;
+    Lock.unlock();
+
+    emit UsageUpdated();
+}
+
+bool RetentionManager::Evict(const OutputUsage &Output)
+{
+    QString EvictedPath = Output.Path + ".evicted";
+
+    // Move the output out of the way without letting go of the lock, so it can't get pinned (and built to) between checking & removing it.
+    QMutexLocker Lock(&Mutex);
+    if (PinCounts.contains(Output.Path) || !Tracked.contains(Output.Path))
+    {
+        return false;
+    }
+
+    // Left behind by an eviction that was interrupted.
+    if (QFileInfo::exists(EvictedPath))
+    {
+        QDir(EvictedPath).removeRecursively();
+    }
+
+    // Record the removal before moving it, so if we die before it's deleted the next cleanup finishes the job.
+    PendingRemovals.insert(EvictedPath);
+    WriteManifest();
+
+    if (!QDir().rename(Output.Path, EvictedPath))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Move Output " << Output.Path << " Out Of The Way To Evict It.";
+#endif
+        PendingRemovals.remove(EvictedPath);
+        WriteManifest();
+        return false;
+    }
+
+    Tracked.remove(Output.Path);
+    Lock.unlock();
+
+#ifdef QT_DEBUG
+    qDebug() << "Evicting Output " << Output.Path << " (" << Output.Size << " Bytes, Last Used " << Output.LastAccess << ")";
+#endif
+
+    bool bRemoved = QDir(EvictedPath).removeRecursively();
+
+    // Clean up the plugin/version directories if this was the last output in them (but never go above the output root).
+    if (!OutputRoot.isEmpty())
+    {
+        QDir Parent = QFileInfo(Output.Path).dir();
+        while (NormalizePath(Parent.absolutePath()).startsWith(OutputRoot + "/") && QDir().rmdir(Parent.absolutePath()))
+        {
+            Parent.cdUp();
+        }
+    }
+
+    Lock.relock();
+    if (bRemoved)
+    {
+        PendingRemovals.remove(EvictedPath);
+    }
+    WriteManifest();
+
+    return true;
+}
+
+void RetentionManager::RemoveEvictedOutputs()
+{
+    QMutexLocker Lock(&Mutex);
+    QList<QString> Removals = PendingRemovals.values();
+    Lock.unlock();
+
+    if (Removals.isEmpty())
+    {
+        return;
+    }
+
+    QStringList Removed;
+    for (QString EvictedPath : Removals)
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Finishing Interrupted Eviction Of " << EvictedPath;
+#endif
+        // Nothing left to do if it's already gone (eg. the user deleted it).
+        if (!QFileInfo::exists(EvictedPath) || QDir(EvictedPath).removeRecursively())
+        {
+            Removed.append(EvictedPath);
+        }
+    }
+
+    Lock.relock();
+    for (QString EvictedPath : Removed)
+    {
+        PendingRemovals.remove(EvictedPath);
+    }
+    WriteManifest();
+}
+
+void RetentionManager::FindUntrackedOutputs(QString Path, int Depth, OutputUsage Output, QList<OutputUsage> &Outputs)
+{
+    if (Depth == Components.size())
+    {
+        QMutexLocker Lock(&Mutex);
+        bool bKnown = Tracked.contains(Path) || PinCounts.contains(Path);
+        Lock.unlock();
+
+        if (bKnown)
+        {
+            return;
+        }
+
+        // Same as a cleanup scan, so imported outputs are ranked against the tracked ones by when they were last built.
+        QDirIterator It(Path, QDir::Files | QDir::Hidden | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+        while (It.hasNext())
+        {
+            It.next();
+            Output.Size += It.fileInfo().size();
+            Output.LastAccess = Latest(Output.LastAccess, It.fileInfo().lastModified());
+        }
+
+        Output.Path = Path;
+        Outputs.append(Output);
+        return;
+    }
+
+    const FormatComponent &Component = Components[Depth];
+    for (QString Name : QDir(Path).entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        if (isInterruptionRequested())
+        {
+            return;
+        }
+
+        // Half evicted outputs aren't outputs anymore.
+        if (Name.endsWith(".evicted"))
+        {
+            continue;
+        }
+
+        QRegularExpressionMatch Match = Component.Expression.match(Name);
+        if (!Match.hasMatch())
+        {
+            continue;
+        }
+
+        OutputUsage Matched = Output;
+        for (int i = 0; i < Component.Specifiers.length(); i++)
+        {
+            QString Captured = Match.captured(i + 1);
+            switch (Component.Specifiers.at(i).toLatin1())
+            {
+            case 'n':
+                Matched.PluginName = Captured;
+                break;
+            case 'v':
+                Matched.PluginVersion = Captured;
+                break;
+            case 'e':
+                Matched.EngineName = Captured;
+                break;
+            }
+        }
+
+        FindUntrackedOutputs(Path + "/" + Name, Depth + 1, Matched, Outputs);
+    }
+}
+
+void RetentionManager::SaveManifest()
+{
+    QMutexLocker Lock(&Mutex);
+    WriteManifest();
+}
+
+void RetentionManager::WriteManifest()
+{
+    QJsonObject jOutputs;
+    for (OutputUsage Output : Tracked)
+    {
+        QJsonObject jOutput;
+        jOutput["plugin"] = Output.PluginName;
+        jOutput["version"] = Output.PluginVersion;
+        jOutput["engine"] = Output.EngineName;
+        jOutput["lastAccess"] = Output.LastAccess.toString(Qt::ISODate);
+
+        jOutputs[Output.Path] = jOutput;
+    }
+
+    QJsonArray jEvicting;
+    for (QString EvictedPath : PendingRemovals)
+    {
+        jEvicting.append(EvictedPath);
+    }
+
+    QJsonObject jManifest;
+    jManifest["outputs"] = jOutputs;
+    jManifest["evicting"] = jEvicting;
+
+    // Both threads save, so keep the lock until it's written to avoid an older copy overwriting a newer one.
+    QSaveFile ManifestFile(ManifestPath);
+    if (ManifestFile.open(QFile::WriteOnly | QFile::Text))
+    {
+        ManifestFile.write(QJsonDocument(jManifest).toJson());
+        ManifestFile.commit();
+    }
+}
+
+QString RetentionManager::NormalizePath(QString Path)
+{
+    return QDir::cleanPath(QFileInfo(QDir::fromNativeSeparators(Path)).absoluteFilePath());
+}
+
+QString RetentionManager::GetExistingPath(QString Path)
+{
+    QString ExistingPath = NormalizePath(Path);
+    while (!QFileInfo::exists(ExistingPath) && QFileInfo(ExistingPath).absolutePath() != ExistingPath)
+    {
+        ExistingPath = QFileInfo(ExistingPath).absolutePath();
+    }
+
+    return ExistingPath;
+}
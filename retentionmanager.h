@@ -0,0 +1,150 @@
+#ifndef RETENTIONMANAGER_H
+#define RETENTIONMANAGER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QDateTime>
+#include <QHash>
+#include <QSet>
+#include <QStringList>
+#include <QRegularExpression>
+
+// A single built plugin directory in the output tree.
+struct OutputUsage
+{
+    QString Path;
+    QString PluginName;
+    QString PluginVersion;
+    QString EngineName;
+
+    qint64 Size = 0;
+    QDateTime LastAccess;
+};
+
+// Keeps the built plugins' output tree (see the build target format) from filling up the disk, by evicting the least recently used outputs in the background.
+/// NOTE: Configured through uPBT's settings: RetentionQuotaMB (0 = unlimited), RetentionKeepVersions (versions kept per plugin, 0 = all), RetentionMinFreeMB & RetentionEvictWhenLowOnSpace.
+/// NOTE: Only directories uPBT has built to (see Track) or the user has chosen to import (see ImportScanned) are ever measured or evicted - anything else in or around the output tree is left alone.
+class RetentionManager : public QThread
+{
+    Q_OBJECT
+
+public:
+    RetentionManager(QString TargetFormat, QObject *parent = 0);
+    ~RetentionManager();
+
+    // Measure the tracked outputs & enforce the policies on the background thread.
+    void RequestCleanup();
+
+    // Whether the target's drive has enough free space for a build right now.
+    bool HasFreeSpace(QString TargetPath);
+
+    // Whether outputs may be evicted to make room for builds.
+    bool CanFreeSpace();
+
+    // Evict outputs on the background thread until there's enough free space for the target. Emits SpaceRequestFinished once done.
+    void RequestSpace(QString TargetPath);
+
+    // Record that uPBT is building to the output, which makes it a candidate for eviction from now on.
+    void Track(QString OutputPath, QString PluginName, QString PluginVersion, QString EngineName);
+
+    // Record that an output was just built/used, so it's the last to be evicted.
+    void Touch(QString OutputPath);
+
+    // Never evict an output while it is being built to. Pins are counted, so the output stays pinned until every build to it has unpinned it.
+    void Pin(QString OutputPath);
+    void Unpin(QString OutputPath);
+
+    // Whether a build is currently building to the output.
+    bool IsPinned(QString OutputPath);
+
+    // Look for existing directories that match the target format (eg. built by older versions of uPBT) but aren't tracked, on the background thread. Emits ImportScanFinished once done.
+    void RequestImportScan();
+
+    // Start tracking the directories the last import scan found, so they count towards (and may be evicted by) the policies.
+    void ImportScanned();
+
+    // The outputs (& their sizes) as of the last scan.
+    QList<OutputUsage> GetUsage();
+
+signals:
+    void UsageUpdated();
+
+    // A space request has been handled, and the target's drive does (or still doesn't) have enough free space.
+    void SpaceRequestFinished(QString TargetPath, bool bSucceeded);
+
+    // An import scan found this many untracked outputs, taking up this many bytes.
+    void ImportScanFinished(int Count, qint64 Size);
+
+protected:
+    void run() override;
+
+private:
+    // How a single directory level of the target format is matched, and which specifiers (n, v or e) its groups capture.
+    struct FormatComponent
+    {
+        QRegularExpression Expression;
+        QString Specifiers;
+    };
+
+    // Kick off the background thread, unless it's already running (in which case it'll pick up whatever was just requested).
+    void StartIfIdle();
+
+    void LoadSettings();
+
+    // Measure the tracked outputs, evict whatever the policies say has to go, and publish the remaining usage.
+    void Cleanup();
+
+    // Finish removing outputs that were moved out of the way to be evicted, but never got deleted (eg. because we crashed).
+    void RemoveEvictedOutputs();
+
+    // Find (and measure) the untracked directories below the path that match the rest of the target format.
+    void FindUntrackedOutputs(QString Path, int Depth, OutputUsage Output, QList<OutputUsage> &Outputs);
+
+    // Remove an output (and any parent directories below the output root that are left empty). Returns false for pinned outputs.
+    bool Evict(const OutputUsage &Output);
+
+    void SaveManifest();
+
+    // Same as SaveManifest, for when the lock is already held.
+    void WriteManifest();
+
+    static QString NormalizePath(QString Path);
+
+    // The closest existing directory to the path, so the drive it will end up on can be checked before it's created.
+    static QString GetExistingPath(QString Path);
+
+    // The directory shared by all outputs (eg. ".../BuiltPlugins"), which empty parent directories are cleaned up to.
+    QString OutputRoot;
+
+    // The target format's directory levels below the output root (only used to find existing outputs to import).
+    QList<FormatComponent> Components;
+
+    QString ManifestPath;
+
+    // Guards everything below, as it's shared between the UI & cleanup threads.
+    QMutex Mutex;
+
+    qint64 QuotaBytes = 0;
+    int KeepVersions = 0;
+    qint64 MinFreeBytes = 0;
+    bool bEvictWhenLowOnSpace = false;
+
+    // Every output uPBT has built to (by path), with its plugin/version/engine & when it was last used. Sizes are only filled in by scans.
+    QHash<QString, OutputUsage> Tracked;
+    QHash<QString, int> PinCounts;
+    QList<OutputUsage> Usage;
+
+    // Outputs that have been moved out of the way (to "<path>.evicted") but not deleted yet - kept in the manifest so they can't leak.
+    QSet<QString> PendingRemovals;
+
+    bool bImportScanRequested = false;
+    QList<OutputUsage> ImportCandidates;
+
+    // Targets waiting on the cleanup thread to make room for them.
+    QStringList SpaceRequests;
+
+    bool bActive = false;
+    bool bRerun = false;
+};
+
+#endif // RETENTIONMANAGER_H
@@ -4,7 +4,7 @@
 #
 #-------------------------------------------------
 
-QT       += core gui
+QT       += core gui network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -27,12 +27,28 @@ SOURCES += \
         main.cpp \
         mainwindow.cpp \
     unrealinstall.cpp \
-    builderrordialog.cpp
+    builderrordialog.cpp \
+    buildjournal.cpp \
+    contentstore.cpp \
+    buildconnection.cpp \
+    buildcoordinator.cpp \
+    buildworker.cpp \
+    buildlogindex.cpp \
+    retentionmanager.cpp \
+    processtree.cpp
 
 HEADERS += \
         mainwindow.h \
     unrealinstall.h \
-    builderrordialog.h
+    builderrordialog.h \
+    buildjournal.h \
+    contentstore.h \
+    buildconnection.h \
+    buildcoordinator.h \
+    buildworker.h \
+    buildlogindex.h \
+    retentionmanager.h \
+    processtree.h
 
 FORMS += \
         mainwindow.ui \
@@ -1,4 +1,12 @@
 #include "unrealinstall.h"
+#include <QStandardPaths>
+#include <QtDebug>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QSettings>
 
 
 UnrealInstall::UnrealInstall()
@@ -38,8 +46,160 @@ QString UnrealInstall::GetPath()
     return EnginePath;
 }
 
+QString UnrealInstall::GetRunUATPath()
+{
+#ifdef Q_OS_WIN
+    return EnginePath + "/Engine/Build/BatchFiles/RunUAT.bat";
+#else
+    return EnginePath + "/Engine/Build/BatchFiles/RunUAT.sh";
+#endif
+}
+
+QString UnrealInstall::GetVersion()
+{
+    QFile BuildVersion(EnginePath + "/Engine/Build/Build.version");
+    if (!BuildVersion.open(QFile::ReadOnly | QFile::Text))
+    {
+        return QString();
+    }
+
+    QJsonObject jBuildVersion = QJsonDocument::fromJson(BuildVersion.readAll()).object();
+    if (!jBuildVersion.contains("MajorVersion") || !jBuildVersion.contains("MinorVersion"))
+    {
+        return QString();
+    }
+
+    return QString("%1.%2.%3").arg(jBuildVersion["MajorVersion"].toInt()).arg(jBuildVersion["MinorVersion"].toInt()).arg(jBuildVersion["PatchVersion"].toInt());
+}
+
+bool UnrealInstall::IsSameEngine(QString NameA, QString VersionA, QString NameB, QString VersionB)
+{
+    if (!VersionA.isEmpty() && !VersionB.isEmpty())
+    {
+        return VersionA == VersionB;
+    }
+
+    // Fall back to the name if we don't know the version of one of them.
+    return NameA == NameB;
+}
+
 bool UnrealInstall::operator==(const UnrealInstall &other) const
 {
     // We only care about path name as the name is (mainly, if not only) there for cosmetic/display purposes
     return EnginePath == other.EnginePath;
 }
+
+QList<UnrealInstall> UnrealInstall::GetEngineInstalls()
+{
+    // Get the ue4 versions
+    QList<UnrealInstall> UnrealInstalls;
+
+    // Fetch the binary install locations (for windows).
+
+#ifdef Q_OS_WIN
+
+    QStringList paths = QStandardPaths::standardLocations(QStandardPaths::GenericDataLocation);
+    QString ProgramDataPath;
+
+    for (QString path : paths)
+    {
+        // Assuming that the *real* one is the only one ending in ProgramData
+        if (path.endsWith("ProgramData"))
+        {
+            ProgramDataPath = path;
+            break;
+        }
+
+#ifdef QT_DEBUG
+    qDebug() << "Found GenericDataLocation Path: " << path;
+#endif
+
+    }
+    QString LauncherInstalledPath = ProgramDataPath + "/Epic/UnrealEngineLauncher/LauncherInstalled.dat";
+
+    QFile LauncherInstalled(LauncherInstalledPath);
+
+    if (!LauncherInstalled.open(QFile::ReadOnly | QFile::Text))
+    {
+#ifdef QT_DEBUG
+        qDebug() << "Unable To Open LauncherInstalled.dat Engine Configuration File....Skipping Automatic Engine Detection. Path: " << LauncherInstalledPath;
+#endif
+
+        return UnrealInstalls;
+
+    }
+    QTextStream LauncherInstalledTS(&LauncherInstalled);
+    QString LauncherInstalledText = LauncherInstalledTS.readAll();
+
+    QJsonObject jLauncherInstalled = QJsonDocument::fromJson(LauncherInstalledText.toUtf8()).object();
+
+    if (!jLauncherInstalled.contains("InstallationList") && jLauncherInstalled["InstallationList"].isArray())
+    {
+#ifdef QT_DEBUG
+         qDebug() << "Invalid LauncherInstalled.dat Engine Configuration File....Skipping Automatic Engine Detection";
+#endif
+
+         return UnrealInstalls;
+    }
+
+    for (QJsonValue EngineInstallVal : jLauncherInstalled["InstallationList"].toArray())
+    {
+        if (!EngineInstallVal.isObject())
+        {
+#ifdef QT_DEBUG
+         qDebug() << "Invalid Launcher Install....skipping this one!";
+         continue;
+#endif
+        }
+
+        QJsonObject EngineInstall = EngineInstallVal.toObject();
+
+        QString EngineLocation = EngineInstall["InstallLocation"].toString();
+        QString EngineName = EngineInstall["AppName"].toString();
+
+        // Only get the ue4 builds - filter out the plugins  (that'll be formatted like ConfigBPPlugin_4.17
+        if (EngineName.startsWith("UE_"))
+        {
+            // Add this engine version to the unreal engine installs list
+            UnrealInstalls.append(UnrealInstall(EngineName, EngineLocation));
+
+#ifdef QT_DEBUG
+            qDebug() << "Found Engine Version: {Name=" << EngineName << ";Location=" << EngineLocation << "}";
+#endif
+        }
+
+    }
+
+#endif
+
+    // Fetch any custom ue4 install paths the user may have added
+
+    // Open up uPBT's settings file
+    QSettings Settings("HowToCompute", "uPBT");
+
+    // Create a quick list to add the custom installs to (so they can be added seperate of the *proper* list in case anything goes wrong)
+    QList<UnrealInstall> CustomInstalls;
+
+    // Read the Custom Unreal Engine Installs array from the settings object.
+    int size = Settings.beginReadArray("CustomUnrealEngineInstalls");
+    for (int i = 0; i < size; ++i) {
+        // Get this element out of the settings
+        Settings.setArrayIndex(i);
+
+        // Extract the installation's name & path
+        QString InstallName = Settings.value("Name").toString();
+        QString InstallPath = Settings.value("Path").toString();
+
+        // Create an UnrealInstall based on the name & path, and add it to the Custom Installs list.
+        CustomInstalls.append(UnrealInstall(InstallName, InstallPath));
+    }
+
+    // Done reading, so "close" the array.
+    Settings.endArray();
+
+    // Add the list of custom installs to the list of (binary) Unreal Engine installations.
+    UnrealInstalls += CustomInstalls;
+
+    // Return the final list of UE4 binary installs & custom installs.
+    return UnrealInstalls;
+}
@@ -2,6 +2,7 @@
 #define UNREALINSTALL_H
 
 #include <QObject>
+#include <QList>
 
 class UnrealInstall
 {
@@ -20,8 +21,20 @@ public:
     QString GetName();
     QString GetPath();
 
+    // Get the path to the engine's RunUAT script for the platform we're running on.
+    QString GetRunUATPath();
+
+    // Get the engine's version (eg. "4.20.3") from Engine/Build/Build.version, or an empty string if it can't be read.
+    QString GetVersion();
+
+    // Whether two installs are the same engine - by version if both are known, as names are mostly cosmetic (and custom installs all default to the same one).
+    static bool IsSameEngine(QString NameA, QString VersionA, QString NameB, QString VersionB);
+
     bool operator==(const UnrealInstall &other) const;
 
+    // Find all of the launcher installs (windows only) & the custom installs the user has added.
+    static QList<UnrealInstall> GetEngineInstalls();
+
 private:
     QString EngineName;
     QString EnginePath;